@@ -0,0 +1,209 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#include "Aggregator.h"
+#include <omnetpp.h>
+#include <algorithm>
+#include <cstring>
+using namespace omnetpp;
+using namespace std;
+
+Define_Module(Aggregator);
+
+Aggregator::~Aggregator() {
+    delete selector;
+    for (auto &entry : pending)
+        cancelAndDelete(entry.second.timer);
+    for (SubtaskTimer *timer : freeTimers)
+        delete timer;
+}
+
+void Aggregator::initialize() {
+    int totalServers = par("totalServers");
+    earlyQuorum = par("earlyQuorum");
+    subtaskTimeout = par("subtaskTimeout");
+    if (subtaskTimeout < SIMTIME_ZERO)
+        throw cRuntimeError("subtaskTimeout must not be negative");
+
+    // Find the server behind each serverOut[] gate, as the clients do for their out[] gates.
+    serverGates.assign(totalServers, -1);
+    for (int k = 0; k < gateSize("serverOut"); k++) {
+        cModule *server = gate("serverOut", k)->getPathEndGate()->getOwnerModule();
+        int serverIndex = (server && strcmp(server->getName(), "s") == 0) ? server->getIndex() : -1;
+        if (serverIndex < 0 || serverIndex >= totalServers)
+            throw cRuntimeError("Gate serverOut[%d] is not connected to a server", k);
+        serverGates[serverIndex] = k;
+        serverLoad.servers.push_back(serverIndex);
+    }
+    if (serverLoad.servers.empty())
+        throw cRuntimeError("Aggregator is not connected to any server");
+    sort(serverLoad.servers.begin(), serverLoad.servers.end());
+    serverLoad.outstanding.assign(totalServers, 0);
+    serverLoad.queueLength.assign(totalServers, 0);
+    serverLoad.reputation.assign(totalServers, 0);
+    scores.assign(totalServers, 0);
+    selector = createReplicaSelector(par("replicaSelection").stdstringValue());
+    selector->beginRound(serverLoad);
+
+    responsesAggregatedSignal = registerSignal("responsesAggregated");
+    cancelsSentSignal = registerSignal("cancelsSent");
+    timeoutsSignal = registerSignal("timeouts");
+    allocationsSignal = registerSignal("allocations");
+    EV << "Aggregator " << getIndex() << " serves " << serverLoad.servers.size() << " servers\n";
+}
+
+void Aggregator::handleMessage(cMessage *msg) {
+    AllocationProbe probe(this, allocationsSignal);
+    if (SubtaskTimer *timer = dynamic_cast<SubtaskTimer *>(msg)) {
+        subtaskTimedOut(timer);
+        return;
+    }
+    SubtaskRequest *req = dynamic_cast<SubtaskRequest *>(msg);
+    if (!req)
+        throw cRuntimeError("Unexpected message '%s' (%s)", msg->getName(), msg->getClassName());
+    if (msg->arrivedOn("serverIn"))
+        handleResponse(req);
+    else
+        forwardRequest(req);
+}
+
+void Aggregator::forwardRequest(SubtaskRequest *req) {
+    int ticket = nextTicket++;
+    Pending &subtask = pending[ticket];
+    subtask.clientGate = req->getArrivalGate()->getIndex();
+    subtask.jobId = req->getJobId();
+    subtask.subtaskId = req->getSubtaskId();
+    subtask.round = req->getRound();
+    subtask.votes.clear();
+    subtask.timer = nullptr;
+
+    // The policy re-ranks the servers whenever the local scores have changed.
+    if (scoresChanged) {
+        for (int serverIndex : serverLoad.servers)
+            serverLoad.reputation[serverIndex] = scores[serverIndex];
+        serverLoad.reputationKnown = true;
+        selector->beginRound(serverLoad);
+        scoresChanged = false;
+    }
+    int replicas = max(1, min(req->getReplicas(), (int)serverLoad.servers.size()));
+    selector->select(serverLoad, replicas, getRNG(0), subtask.votes.assigned);
+    subtask.votes.needed = subtask.votes.assigned.size();
+
+    req->setJobId(ticket);
+    req->setReplicas(0);
+    for (int serverIndex : subtask.votes.assigned) {
+        serverLoad.outstanding[serverIndex]++;
+        send(requestPool.copyOf(*req), "serverOut", serverGates[serverIndex]);
+    }
+    req->setData(SubtaskData());   // Do not keep the client's array alive from the pool.
+    requestPool.release(req);
+
+    if (subtaskTimeout > SIMTIME_ZERO) {
+        if (freeTimers.empty()) {
+            subtask.timer = new SubtaskTimer("SubtaskTimeout");
+        } else {
+            subtask.timer = freeTimers.back();
+            freeTimers.pop_back();
+        }
+        subtask.timer->setJobId(ticket);
+        scheduleAt(simTime() + subtaskTimeout, subtask.timer);
+    }
+}
+
+void Aggregator::handleResponse(SubtaskRequest *resp) {
+    int serverIndex = resp->getServerIndex();
+    serverLoad.queueLength[serverIndex] = resp->getQueueLength();
+    auto it = pending.find(resp->getJobId());
+    if (it == pending.end()) {
+        requestPool.release(resp);   // Already decided; sendResult cancelled this replica.
+        return;
+    }
+    serverLoad.outstanding[serverIndex]--;
+    int ticket = it->first;
+    Pending &subtask = it->second;
+    SubtaskVotes &votes = subtask.votes;
+    votes.servers.push_back(serverIndex);
+    votes.results.emplace_back(resp->getResultArraySize());
+    for (size_t i = 0; i < resp->getResultArraySize(); i++)
+        votes.results.back()[i] = resp->getResult(i);
+    votes.malicious.push_back(resp->getMalicious());
+    votes.corrupted.push_back(resp->getCorrupted());
+    requestPool.release(resp);
+
+    int outstanding = votes.needed - (int)votes.size();
+    if (outstanding == 0) {
+        sendResult(ticket, subtask, majorityVote(votes));
+    } else if (earlyQuorum) {
+        int winner = majorityVote(votes, outstanding);
+        if (winner >= 0)
+            sendResult(ticket, subtask, winner);
+    }
+}
+
+void Aggregator::subtaskTimedOut(SubtaskTimer *timer) {
+    auto it = pending.find(timer->getJobId());
+    if (it == pending.end() || it->second.timer != timer)
+        throw cRuntimeError("Timeout for unknown ticket %d", timer->getJobId());
+    Pending &subtask = it->second;
+    emit(timeoutsSignal, (long)(subtask.votes.needed - subtask.votes.size()));
+    EV_WARN << "Aggregator " << getIndex() << ": Subtask_" << subtask.subtaskId << " of Job " << subtask.jobId
+            << " timed out with " << subtask.votes.size() << " of " << subtask.votes.needed << " responses\n";
+    sendResult(it->first, subtask, majorityVote(subtask.votes));   // -1 (an empty result) without responses.
+}
+
+void Aggregator::sendResult(int ticket, Pending &subtask, int winner) {
+    SubtaskVotes &votes = subtask.votes;
+    AggregateResult *result = new AggregateResult("AggregateResult");
+    result->setJobId(subtask.jobId);
+    result->setSubtaskId(subtask.subtaskId);
+    result->setRound(subtask.round);
+    result->setAggregatorIndex(getIndex());
+    result->setReplicas(votes.assigned.size());
+    if (winner >= 0) {
+        const KernelResult &decided = votes.results[winner];
+        result->setResultArraySize(decided.size());
+        for (size_t i = 0; i < decided.size(); i++)
+            result->setResult(i, decided[i]);
+    }
+    result->setVotesArraySize(votes.size());
+    for (size_t i = 0; i < votes.size(); i++) {
+        AggregateVote &vote = result->getVotesForUpdate(i);
+        vote.serverIndex = votes.servers[i];
+        vote.agreed = winner >= 0 && votes.results[i] == votes.results[winner];
+        vote.malicious = votes.malicious[i];
+        vote.corrupted = votes.corrupted[i];
+        if (vote.agreed) {
+            scores[vote.serverIndex]++;
+            scoresChanged = true;
+        }
+    }
+    emit(responsesAggregatedSignal, (long)votes.size());
+
+    // Replicas still working on an early-decided subtask are told to drop it.
+    int cancels = 0;
+    for (int serverIndex : votes.assigned) {
+        if (find(votes.servers.begin(), votes.servers.end(), serverIndex) != votes.servers.end())
+            continue;
+        SubtaskCancel *cancel = new SubtaskCancel("Cancel");
+        cancel->setJobId(ticket);
+        cancel->setSubtaskId(subtask.subtaskId);
+        cancel->setRound(subtask.round);
+        send(cancel, "serverOut", serverGates[serverIndex]);
+        serverLoad.outstanding[serverIndex]--;
+        cancels++;
+    }
+    if (cancels > 0)
+        emit(cancelsSentSignal, cancels);
+
+    if (getEnvir()->isLoggingEnabled())
+        EV << "Aggregator " << getIndex() << " decided Subtask_" << subtask.subtaskId << " of Job "
+           << subtask.jobId << " on " << votes.size() << " of " << votes.assigned.size() << " responses\n";
+    send(result, "out", subtask.clientGate);
+    if (subtask.timer) {
+        cancelEvent(subtask.timer);
+        freeTimers.push_back(subtask.timer);
+    }
+    pending.erase(ticket);
+}
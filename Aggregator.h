@@ -0,0 +1,106 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _AGGREGATOR_H
+#define _AGGREGATOR_H
+
+#include <omnetpp.h>
+#include <unordered_map>
+#include <vector>
+#include "TaskMessages_m.h"
+#include "Voting.h"
+#include "ReplicaSelector.h"
+#include "MessagePool.h"
+#include "AllocationCounter.h"
+using namespace omnetpp;
+using namespace std;
+
+/**
+ * @brief Optional tier between the clients and a group of servers that votes on their behalf.
+ *
+ * With the network's 'aggregatorFanout' > 0, every 'aggregatorFanout' servers
+ * form a group behind one aggregator, and clients talk only to aggregators.
+ * A client sends each subtask once, with the number of replicas it wants; the
+ * aggregator picks that many servers of its group (at most all of them) with
+ * its own ReplicaSelector, forwards copies of the request and runs the
+ * majority vote (see Voting.h) on their responses. Only the decided value goes
+ * back to the client, in an AggregateResult with one vote entry per response,
+ * so the client receives one message per subtask however many servers there are.
+ *
+ * The copies carry the aggregator's own ticket number in jobId, because the
+ * job ids of different clients collide; servers echo it back. With
+ * 'earlyQuorum', a subtask is decided as soon as its majority is unbeatable
+ * and the remaining replicas are cancelled. The aggregator keeps a local score
+ * per server (one point per agreeing vote), which the "top" policy ranks by;
+ * the policy re-ranks only when the scores have changed.
+ *
+ * A subtask still short of responses 'subtaskTimeout' after it was forwarded
+ * (a crashed, lossy or very slow server) is decided on the responses it has;
+ * the late replicas are cancelled. Without any response the client receives an
+ * empty result and counts the subtask as failed.
+ *
+ * Servers reply on the gate the request arrived on, so serverOut[k] and
+ * serverIn[k] must lead to the same server (myNetwork.ned wires them in pairs).
+ */
+class Aggregator : public cSimpleModule {
+  private:
+    // A subtask being voted on.
+    struct Pending {
+        int clientGate;                         // in[] / out[] index of the client.
+        int jobId;                              // The client's ids of the subtask.
+        int subtaskId;
+        int round;
+        SubtaskVotes votes;                     // Responses so far; votes.assigned = servers sent to.
+        SubtaskTimer *timer;                    // Timeout of the subtask (nullptr without subtaskTimeout).
+    };
+    unordered_map<int, Pending> pending;        // By ticket number.
+    int nextTicket = 0;
+
+    // Servers of the group.
+    vector<int> serverGates;                    // serverOut[] index of each server, by server index (-1 if not in the group).
+    ServerLoad serverLoad;                      // Outstanding requests, queue lengths and local scores per server.
+    ReplicaSelector *selector = nullptr;        // Policy chosen by the 'replicaSelection' parameter.
+    vector<int> scores;                         // Agreeing votes per server.
+    bool scoresChanged = false;                 // Scores changed since the policy last ranked the servers.
+    bool earlyQuorum;
+    simtime_t subtaskTimeout;                   // Time a subtask may wait for its responses (0 = forever).
+    vector<SubtaskTimer *> freeTimers;          // Timers of decided subtasks, for reuse.
+    MessagePool<SubtaskRequest> requestPool;    // Requests of clients and responses of servers, for reuse.
+
+    // Statistics signals.
+    simsignal_t responsesAggregatedSignal;      // Server responses folded into each result sent to a client.
+    simsignal_t cancelsSentSignal;              // Replicas cancelled for an early-decided subtask.
+    simsignal_t timeoutsSignal;                 // Replicas given up when their subtask timed out.
+    simsignal_t allocationsSignal;              // Heap allocations per event (needs COUNT_ALLOCS=1).
+
+    /**
+     * @brief Forwards a client's request to the chosen servers of the group.
+     */
+    void forwardRequest(SubtaskRequest *req);
+
+    /**
+     * @brief Records a server's response and decides the subtask once it can.
+     */
+    void handleResponse(SubtaskRequest *resp);
+
+    /**
+     * @brief Decides a subtask whose timeout expired on the responses it has.
+     */
+    void subtaskTimedOut(SubtaskTimer *timer);
+
+    /**
+     * @brief Sends the decided value and vote summary to the client and forgets the subtask.
+     */
+    void sendResult(int ticket, Pending &subtask, int winner);
+
+  protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage *msg) override;
+
+  public:
+    virtual ~Aggregator();
+};
+
+#endif // _AGGREGATOR_H
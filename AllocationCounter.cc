@@ -0,0 +1,41 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef COUNT_ALLOCATIONS
+
+// Per thread, so the allocations of the file loggers' writer thread are not charged to
+// whatever event the simulation thread happens to be running. Constant-initialized, so it
+// is usable from operator new at any time.
+static thread_local uint64_t allocations = 0;
+
+uint64_t allocationCount() {
+    return allocations;
+}
+
+static void *countedAlloc(size_t size) {
+    allocations++;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size) { return countedAlloc(size); }
+void *operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+
+#else
+
+uint64_t allocationCount() {
+    return 0;
+}
+
+#endif
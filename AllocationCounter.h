@@ -0,0 +1,56 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _ALLOCATIONCOUNTER_H
+#define _ALLOCATIONCOUNTER_H
+
+#include <omnetpp.h>
+#include <cstdint>
+using namespace omnetpp;
+
+/*
+ * Heap allocation counting, for checking that the per-event hot path stays
+ * allocation-free. "make COUNT_ALLOCS=1" (see makefrag) compiles in replacements
+ * of the global operator new/delete that count every allocation made by the
+ * simulation, the OMNeT++ kernel included. Counts are kept per thread, so
+ * background threads such as the FileLogger writer do not show up in the
+ * simulation thread's count. Without the flag nothing is replaced and the
+ * count stays 0. Run "make clean" when switching this flag.
+ */
+#ifdef COUNT_ALLOCATIONS
+#define ALLOCATION_COUNTING_ENABLED 1
+#else
+#define ALLOCATION_COUNTING_ENABLED 0
+#endif
+
+/**
+ * @brief Number of operator new calls made by the calling thread so far (0 if counting is off).
+ */
+uint64_t allocationCount();
+
+/**
+ * @brief Emits the number of heap allocations made while it is in scope.
+ *
+ * Declared at the top of handleMessage(), it reports the allocations of each
+ * event on the given signal when it goes out of scope. Without COUNT_ALLOCATIONS
+ * it does nothing.
+ */
+class AllocationProbe {
+  public:
+    AllocationProbe(cComponent *component, simsignal_t signal)
+        : component(component), signal(signal), start(allocationCount()) {}
+
+    ~AllocationProbe() {
+        if (ALLOCATION_COUNTING_ENABLED)
+            component->emit(signal, (long)(allocationCount() - start));
+    }
+
+  private:
+    cComponent *component;
+    simsignal_t signal;
+    uint64_t start;
+};
+
+#endif // _ALLOCATIONCOUNTER_H
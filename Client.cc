@@ -8,137 +8,1350 @@
 #include <omnetpp.h>
 #include <sstream>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <algorithm>
-#include <fstream>
+#include <cmath>
 
 using namespace omnetpp;
 using namespace std;
 
 Define_Module(Client);
 
+// Replica latencies kept for the hedging threshold, and the samples needed before hedging starts.
+static const size_t LATENCY_WINDOW = 512;
+static const size_t HEDGE_MIN_SAMPLES = 20;
+
+// Nearest-rank percentile of a sorted, non-empty sample (the hedge window; recorded latency
+// percentiles come from the "percentiles" result recorder).
+static double nearestRank(const vector<double> &sorted, int p) {
+    size_t rank = (size_t)ceil(p / 100.0 * sorted.size());
+    return sorted[max(rank, (size_t)1) - 1];
+}
+
 /*
- * Function: responsesProcessed
- * ----------------------------
- *   Iterates through the responses for each subtask and counts how many subtasks have received
- *   the required number of responses (which is totalServers/2 + 1). This function helps determine
- *   if a client has received all necessary server responses before proceeding with majority voting.
+ * Function: startJob
+ * ------------------
+ *   Creates the next job (reusing a recycled Job object when possible, so its per-subtask
+ *   arrays keep their capacity) and sends its first round.
+ */
+void Client::startJob() {
+    unique_ptr<Job> job;
+    if (!freeJobs.empty()) {
+        job = move(freeJobs.back());
+        freeJobs.pop_back();
+    } else {
+        job.reset(new Job());
+    }
+    if (nextJobId == 0)
+        firstArrival = simTime();
+    job->id = nextJobId++;
+    job->round = 1;
+    job->done = false;
+    job->arrivalTime = simTime();
+    Job &started = *job;
+    jobs.push_back(move(job));
+    emit(jobsInFlightSignal, jobsInFlight());
+    if (logEnabled(LOG_DEBUG))
+        logToFile("Job " + to_string(started.id) + " arrived", LOG_DEBUG);
+    startRound(started);
+}
+
+/*
+ * Function: findJob
+ * -----------------
+ *   Job ids are consecutive and jobs[] is ordered by id, so the lookup is an index computation.
  *
  *   Returns:
- *      The number of subtasks that have received the full set of responses.
+ *      The job with the given id if it is still held in jobs[], otherwise nullptr.
+ */
+Job *Client::findJob(int jobId) {
+    long index = (long)jobId - firstJobId;
+    if (index < 0 || index >= (long)jobs.size())
+        return nullptr;
+    return jobs[index].get();
+}
+
+/*
+ * Function: jobsInFlight
+ * ----------------------
+ *   Number of jobs that have arrived but not completed.
+ */
+int Client::jobsInFlight() const {
+    return nextJobId - (int)jobsCompleted;
+}
+
+/*
+ * Function: allJobsDone
+ * ---------------------
+ *   True once every job of a finite workload has arrived and completed.
+ */
+bool Client::allJobsDone() const {
+    return numJobs > 0 && nextJobId >= numJobs && jobsInFlight() == 0;
+}
+
+/*
+ * Function: startRound
+ * --------------------
+ *   Resets the job's per-subtask state machine and completion counter, then sends the
+ *   round's subtasks. With EQUAL and WEIGHTED partitioning every subtask is sent at once to
+ *   (n/2 + 1) of the linked servers picked by the replica selection policy (see
+ *   ReplicaSelector.h). By default they are chosen at random until any reputation is known,
+ *   and afterwards each subtask goes to the top servers by merged reputation.
+ *   In witness mode the policy picks a single server instead, plus a random second one
+ *   with the server's spot-check probability. With adaptive replication it picks only as
+ *   many servers as the target error rate needs (see chooseAdaptiveReplicas).
+ *   WEIGHTED sizes the chunks only once their servers are known (see cutWeightedChunks).
+ *   GUIDED starts with no chunks at all and lets every linked server pull work (see pullWork).
+ *   With request batching and no batchTimeout, the batches filled by the round are sent
+ *   once all of its subtasks are assigned.
+ */
+void Client::startRound(Job &job) {
+    job.completedSubtasks = 0;
+    job.maliciousReplicas = 0;
+    job.serverWork = 0;
+    job.liesDetected = 0;
+    job.liesMissed = 0;
+    job.wrongResults = 0;
+    job.failedSubtasks = 0;
+    job.roundStartTime = simTime();
+    refreshHedgeDelay();
+    if (!aggregatorGates.empty()) {
+        startAggregatedRound(job);
+        return;
+    }
+
+    // Refresh the reputation the policy sees once per round.
+    if (reputationKnown)
+        for (int serverIndex : linkedServers)
+            serverLoad.reputation[serverIndex] = reputationOf(serverIndex);
+    serverLoad.reputationKnown = reputationKnown;
+    selector->beginRound(serverLoad);
+    if (logEnabled(LOG_INFO)) {
+        string summary = selector->roundSummary(serverLoad);
+        if (!summary.empty())
+            logToFile("Job " + to_string(job.id) + " Round " + to_string(job.round) + ": " + summary);
+    }
+
+    if (partitioning == PARTITION_GUIDED) {
+        resetSubtasks(job, 0);
+        job.nextOffset = 0;
+        job.firstOpenChunk = 0;
+        job.serverChunk.assign(totalServers, -1);
+        for (int serverIndex : linkedServers)
+            pullWork(job, serverIndex);
+        return;
+    }
+
+    int n = numSubtasks;
+    resetSubtasks(job, n);
+    job.nextOffset = arraySize;
+    int numLinks = linkedServers.size();
+    for (int i = 0; i < n; i++) {
+        vector<int> &chosen = job.responses[i].assigned;
+        if (verifyWitness) {
+            selector->select(serverLoad, 1, getRNG(0), chosen);
+            // The spot check is drawn uniformly, so a server cannot predict who checks it.
+            int primary = chosen[0];
+            if (numLinks > 1 && uniform(0, 1) < spotCheckProbability(primary)) {
+                int spotCheck = primary;
+                while (spotCheck == primary)
+                    spotCheck = linkedServers[intuniform(0, numLinks - 1)];
+                chosen.push_back(spotCheck);
+            }
+        } else if (adaptiveReplication) {
+            chooseAdaptiveReplicas(chosen, 1, 1);
+        } else {
+            selector->select(serverLoad, replicationFactor, getRNG(0), chosen);
+        }
+    }
+    if (partitioning == PARTITION_WEIGHTED)
+        cutWeightedChunks(job);
+    else
+        job.chunks = subtasks;
+
+    for (int i = 0; i < n; i++) {
+        const SubtaskRequest *msg = prepareRequest(job, i);
+        SubtaskVotes &votes = job.responses[i];
+        votes.sentAt.assign(votes.assigned.size(), simTime());
+        votes.needed = votes.assigned.size();
+        for (int serverIndex : votes.assigned) {
+            if (logEnabled(LOG_DEBUG)) {
+                stringstream ss;
+                ss << "Job " << job.id << " Round " << job.round << ": Sending " << msg->getName()
+                   << " to Server with index " << serverIndex << " (gate out[" << gateOf(serverIndex) << "])";
+                EV << ss.str() << "\n";
+                logToFile(ss.str(), LOG_DEBUG);
+            }
+            dispatchRequest(msg, serverIndex);
+            job.serverWork += job.chunks[i].size();
+        }
+        armTimer(job, i);
+    }
+    if (batchRequests && batchTimeout == SIMTIME_ZERO)
+        flushBatches();
+}
+
+/*
+ * Function: startAggregatedRound
+ * ------------------------------
+ *   With an aggregator tier, sends each subtask of the round once, to the aggregator with
+ *   the fewest subtasks of this client outstanding (ties rotate). The aggregator runs the
+ *   replicas and the vote and answers with an AggregateResult (see handleAggregateResult).
+ */
+void Client::startAggregatedRound(Job &job) {
+    int n = numSubtasks;
+    resetSubtasks(job, n);
+    job.chunks = subtasks;
+    job.nextOffset = arraySize;
+    int numAggregators = aggregatorGates.size();
+    for (int i = 0; i < n; i++) {
+        int link = nextAggregator++ % numAggregators;
+        for (int k = 1; k < numAggregators; k++) {
+            int candidate = (link + k) % numAggregators;
+            if (aggregatorOutstanding[candidate] < aggregatorOutstanding[link])
+                link = candidate;
+        }
+        aggregatorOutstanding[link]++;
+        job.responses[i].sentAt.push_back(simTime());
+        send(requestPool.copyOf(*prepareRequest(job, i)), "out", aggregatorGates[link]);
+    }
+}
+
+/*
+ * Function: resetSubtasks
+ * -----------------------
+ *   Sizes the job's per-subtask arrays for 'count' subtasks and clears them. The vote lists
+ *   of the subtasks that remain keep their capacity.
+ */
+void Client::resetSubtasks(Job &job, int count) {
+    job.responses.resize(count);
+    for (auto &subtaskVotes : job.responses)
+        subtaskVotes.clear();
+    job.responded.assign((size_t)count * respondedWords, 0);
+    job.subtaskResults.resize(count);
+    for (auto &subtaskResult : job.subtaskResults)
+        subtaskResult.clear();
+    job.subtaskStates.assign(count, SUBTASK_PENDING);
+    job.finalizedAt.assign(count, SIMTIME_ZERO);
+    job.replicasNeeded.assign(count, 0);
+    job.chunks.resize(count);
+    for (SubtaskTimer *timer : job.timers)
+        if (timer)
+            cancelEvent(timer);
+}
+
+/*
+ * Function: addSubtask
+ * --------------------
+ *   GUIDED: appends a freshly cut chunk to the round. It still needs all of its replicas.
+ *
+ *   Returns:
+ *      The id of the new subtask.
+ */
+int Client::addSubtask(Job &job, const SubtaskData &chunk) {
+    int subtaskId = job.chunks.size();
+    job.chunks.push_back(chunk);
+    job.responses.emplace_back();
+    job.responded.resize(job.responded.size() + respondedWords, 0);
+    job.subtaskResults.emplace_back();
+    job.subtaskStates.push_back(SUBTASK_PENDING);
+    job.finalizedAt.push_back(SIMTIME_ZERO);
+    job.replicasNeeded.push_back(replicationFactor);
+    job.responses.back().needed = replicationFactor;
+    return subtaskId;
+}
+
+/*
+ * Function: assignReplica
+ * -----------------------
+ *   Sends one more replica of a subtask of the current round to a server and records it.
+ */
+void Client::assignReplica(Job &job, int subtaskId, int serverIndex) {
+    job.responses[subtaskId].assigned.push_back(serverIndex);
+    job.responses[subtaskId].sentAt.push_back(simTime());
+    dispatchRequest(prepareRequest(job, subtaskId), serverIndex);
+    if (batchRequests && batchTimeout == SIMTIME_ZERO)
+        flushBatch(linkOf(serverIndex));
+    job.serverWork += job.chunks[subtaskId].size();
+    armTimer(job, subtaskId);
+}
+
+/*
+ * Function: pullWork
+ * ------------------
+ *   GUIDED: called when a server has nothing to do for the job (at the start of a round and
+ *   whenever it answers or is cancelled). The server first joins the oldest chunk that still
+ *   needs replicas and that it does not hold yet. Otherwise it cuts a new chunk from the
+ *   rest of the array: 'guidedFraction' of its share of the remaining elements, the share
+ *   being its estimated speed relative to all linked servers (times the replication factor,
+ *   as every chunk occupies that many servers). Chunks therefore shrink towards the end of
+ *   the array, and fast servers take larger ones, so all servers run out of work together.
+ */
+void Client::pullWork(Job &job, int serverIndex) {
+    int n = job.chunks.size();
+    while (job.firstOpenChunk < n && job.replicasNeeded[job.firstOpenChunk] == 0)
+        job.firstOpenChunk++;
+    for (int i = job.firstOpenChunk; i < n; i++) {
+        const vector<int> &assigned = job.responses[i].assigned;
+        if (job.replicasNeeded[i] > 0 && find(assigned.begin(), assigned.end(), serverIndex) == assigned.end()) {
+            job.replicasNeeded[i]--;
+            job.serverChunk[serverIndex] = i;
+            assignReplica(job, i, serverIndex);
+            return;
+        }
+    }
+
+    size_t remaining = arraySize - job.nextOffset;
+    if (remaining == 0)
+        return;
+    double totalSpeed = 0;
+    for (int linked : linkedServers)
+        totalSpeed += speedOf(linked);
+    double share = replicationFactor * speedOf(serverIndex) / totalSpeed;
+    size_t size = max((size_t)ceil(guidedFraction * share * remaining), minChunk);
+    if (size >= remaining || remaining - size < minChunk)
+        size = remaining;   // Do not leave a tail smaller than a chunk.
+    int subtaskId = addSubtask(job, SubtaskData(arrayOwner, arrayElements + job.nextOffset, size));
+    job.nextOffset += size;
+    job.replicasNeeded[subtaskId]--;
+    job.serverChunk[serverIndex] = subtaskId;
+    assignReplica(job, subtaskId, serverIndex);
+}
+
+/*
+ * Function: cutWeightedChunks
+ * ---------------------------
+ *   WEIGHTED: once the servers of every subtask are chosen, cuts the array into the round's
+ *   chunks. A subtask is done when its slowest replica is, so each chunk is weighted by the
+ *   estimated speed of its slowest server. Every chunk gets 'minChunkSize' elements and the
+ *   rest is split in proportion to the weights, so that all chunks take about equally long.
+ */
+void Client::cutWeightedChunks(Job &job) {
+    int n = job.responses.size();
+    chunkWeights.resize(n);
+    double total = 0;
+    for (int i = 0; i < n; i++) {
+        double weight = -1;
+        for (int serverIndex : job.responses[i].assigned)
+            weight = weight < 0 ? speedOf(serverIndex) : min(weight, speedOf(serverIndex));
+        chunkWeights[i] = weight;
+        total += weight;
+    }
+    size_t spare = arraySize - (size_t)n * minChunk;
+    size_t offset = 0;
+    double cumulative = 0;
+    for (int i = 0; i < n; i++) {
+        cumulative += chunkWeights[i];
+        size_t end = (i == n - 1) ? arraySize : (i + 1) * minChunk + (size_t)(spare * (cumulative / total));
+        job.chunks[i] = SubtaskData(arrayOwner, arrayElements + offset, end - offset);
+        offset = end;
+    }
+}
+
+/*
+ * Function: speedOf
+ * -----------------
+ *   Estimated speed (elements per second) of a server. A server that has not been measured
+ *   yet is assumed to be as fast as the average measured one, or 1 if none was measured.
+ */
+double Client::speedOf(int serverIndex) const {
+    if (serverSpeed[serverIndex] > 0)
+        return serverSpeed[serverIndex];
+    return measuredServers > 0 ? speedSum / measuredServers : 1.0;
+}
+
+/*
+ * Function: roundComplete
+ * -----------------------
+ *   All of the array has been cut into chunks and every chunk is finalized.
+ */
+bool Client::roundComplete(const Job &job) const {
+    return job.nextOffset == arraySize && job.completedSubtasks == (int)job.chunks.size();
+}
+
+/*
+ * Function: completeRound
+ * -----------------------
+ *   Called on the response that finalizes the last subtask of a round. Combines the
+ *   subtask results into the final result, logs it and shares the updated scores. Then
+ *   either starts the job's next round or completes the job: its latency is recorded and
+ *   finished jobs at the front of jobs[] are recycled.
+ */
+void Client::completeRound(Job &job) {
+    KernelResult finalResult;
+    for (auto &subtaskResult : job.subtaskResults)
+        if (!subtaskResult.empty())   // Failed subtasks have no result.
+            operation->combine(finalResult, subtaskResult);
+    stringstream finalMsg;
+    finalMsg << "Job " << job.id << " Final Result in Round " << job.round << " = " << resultToString(finalResult);
+    if (job.failedSubtasks > 0)
+        finalMsg << " (partial: " << job.failedSubtasks << " subtasks without a response)";
+    EV << "Client " << getId() << " " << finalMsg.str() << "\n";
+    logToFile(finalMsg.str());
+
+    // Append final result to the common output file.
+    writeOutput("Client " + to_string(getId()) + " Job " + to_string(job.id) + " Round " + to_string(job.round)
+                + " Final Result = " + resultToString(finalResult));
+
+    emit(maliciousReplicasSignal, job.maliciousReplicas);
+    emit(roundMakespanSignal, simTime() - job.roundStartTime);
+    emit(serverWorkSignal, job.serverWork);
+    emit(workRatioSignal, (double)job.serverWork / baselineWork);
+    emit(liesDetectedSignal, job.liesDetected);
+    emit(liesMissedSignal, job.liesMissed);
+    emit(wrongResultsSignal, job.wrongResults);
+
+    // Share the scores of the completed round right away.
+    if (scoresChanged)
+        broadcastGossip();
+
+    if (job.round < roundsPerJob) {
+        job.round++;
+        logToFile("Job " + to_string(job.id) + ": transitioning to Round " + to_string(job.round)
+                  + ". Selecting top servers based on the merged reputation.");
+        startRound(job);
+        return;
+    }
+
+    job.done = true;
+    jobsCompleted++;
+    lastCompletion = simTime();
+    simtime_t latency = simTime() - job.arrivalTime;
+    emit(jobLatencySignal, latency);
+
+    // Retire finished jobs from the front; later jobs may finish first and wait there.
+    while (!jobs.empty() && jobs.front()->done) {
+        freeJobs.push_back(move(jobs.front()));
+        jobs.pop_front();
+        firstJobId++;
+    }
+    emit(jobsInFlightSignal, jobsInFlight());
+}
+
+/*
+ * Function: finalizeSubtask
+ * -------------------------
+ *   Called once majority voting has decided a subtask (PENDING -> QUORUM), with the position
+ *   of the winning response. Records the result, updates the server scores, bumps the
+ *   completion counter and emits the finalization time (QUORUM -> FINALIZED).
+ *   A winner of -1 means that every replica was lost: the subtask is finalized without a
+ *   result and left out of the final result.
  */
-int Client::responsesProcessed() {
-    int count = 0;
-    for (auto &m : responses) {
-       // Each subtask must have responses from (totalServers/2 + 1) servers.
-       if (m.size() == (unsigned)(totalServers / 2 + 1))
-          count++;
+void Client::finalizeSubtask(Job &job, int subtaskId, int winner) {
+    SubtaskVotes &votes = job.responses[subtaskId];
+    job.subtaskStates[subtaskId] = SUBTASK_QUORUM;
+    job.replicasNeeded[subtaskId] = 0;
+    if (subtaskId < (int)job.timers.size() && job.timers[subtaskId])
+        cancelEvent(job.timers[subtaskId]);
+    if (!votes.assigned.empty())   // Behind aggregators the client does not see the replicas.
+        emit(replicasPerSubtaskSignal, (long)votes.assigned.size());
+    if (winner < 0) {
+        job.subtaskResults[subtaskId].clear();
+        job.failedSubtasks++;
+        emit(subtasksFailedSignal, 1);
+        logToFile("Job " + to_string(job.id) + " Subtask_" + to_string(subtaskId) + ": no replica responded, no result", LOG_ERROR);
+        job.subtaskStates[subtaskId] = SUBTASK_FINALIZED;
+        job.finalizedAt[subtaskId] = simTime();
+        job.completedSubtasks++;
+        return;
+    }
+    const KernelResult &majorityVal = votes.results[winner];
+    job.subtaskResults[subtaskId] = majorityVal;
+    if (votes.corrupted[winner])   // Every response with the decided value is equally right or wrong.
+        job.wrongResults++;
+
+    // Update scores: For every response matching the majority, increment the server's score.
+    // A wrong response counts as detected unless its value was adopted. Whether a response is
+    // wrong is reported by its server: a malicious server can still answer correctly from a
+    // non-poisoned result cache, so its malicious flag alone does not tell.
+    int disagreeing = 0;
+    for (int i = 0; i < (int)votes.size(); i++) {
+       if (votes.results[i] == majorityVal) {
+          int serverIndex = votes.servers[i];
+          serverScores[serverIndex] += 1;
+          emit(serverScoreSignals[serverIndex], serverScores[serverIndex]);
+          scoresChanged = true;
+          reputationKnown = true;
+       } else {
+          serverDisagreements[votes.servers[i]]++;
+          disagreeing++;
+       }
+       if (votes.corrupted[i]) {
+          if (votes.results[i] == majorityVal)
+             job.liesMissed++;
+          else
+             job.liesDetected++;
+       }
+    }
+    emit(disagreeingVotesSignal, disagreeing);
+
+    // Log updated scores after processing the subtask.
+    if (traceEnabled(LOG_DEBUG)) {
+        stringstream scoreMsg;
+        scoreMsg << "Updated scores after processing Subtask_" << subtaskId << ": ";
+        for (int i = 0; i < (int)serverScores.size(); i++) {
+            scoreMsg << "Server" << i << "=" << serverScores[i] << " ";
+        }
+        EV << "Client " << getId() << " " << scoreMsg.str() << "\n";
+        logToFile(scoreMsg.str(), LOG_DEBUG);
+    }
+
+    // Log the majority result for the subtask.
+    if (logEnabled(LOG_INFO)) {
+       stringstream subtaskLog;
+       subtaskLog << "Job " << job.id << " Subtask_" << subtaskId << " majority result = " << resultToString(majorityVal);
+       logToFile(subtaskLog.str());
     }
-    return count;
+
+    job.subtaskStates[subtaskId] = SUBTASK_FINALIZED;
+    job.finalizedAt[subtaskId] = simTime();
+    job.completedSubtasks++;
+    emit(subtaskFinalizedSignal, simTime() - job.roundStartTime);
 }
 
 /*
  * Function: logToFile
  * -------------------
- *   This helper function writes a log message to a client-specific log file.
- *   The file name is constructed using the client's module ID to ensure uniqueness.
+ *   This helper function queues a log message for the client-specific log file
+ *   (client_<id>_log.txt). The file is kept open by a shared FileLogger and written in
+ *   batches by its background thread. Messages above the configured 'logLevel' are dropped.
  *
  *   Parameters:
- *      msg - The log message to be written.
+ *      msg   - The log message to be written.
+ *      level - Verbosity of the message (LOG_INFO by default).
  */
-void Client::logToFile(const string &msg) {
-    stringstream filename;
-    filename << "client_" << getId() << "_log.txt";
-    ofstream logFile(filename.str().c_str(), ios::app); // Open file in append mode.
-    if (logFile.is_open()) {
-        logFile << msg << endl;
-        logFile.close();
-    }
+void Client::logToFile(const string &msg, LogLevel level) {
+    if (logFile && logEnabled(level))
+        logFile->write(msg);
+}
+
+/*
+ * Function: writeOutput
+ * ---------------------
+ *   Queues a line for the common output file (outputfile.txt), which is shared by all
+ *   clients through a single FileLogger. Under parallel simulation every partition is a
+ *   separate process, so each one writes its own outputfile_p<partition>.txt instead of
+ *   interleaving appends to one file. Output lines are written unless logging is off.
+ */
+void Client::writeOutput(const string &line) {
+    if (outputFile && logEnabled(LOG_ERROR))
+        outputFile->write(line);
+}
+
+Client::~Client() {
+    FileLogger::release(logFile);
+    FileLogger::release(outputFile);
+    delete operation;
+    cancelAndDelete(gossipTimer);
+    cancelAndDelete(jobArrivalTimer);
+    delete selector;
+    delete requestTemplate;
+    for (cMessage *timer : batchTimers)
+        cancelAndDelete(timer);
+    for (SubtaskBatch *batch : pendingBatches)
+        delete batch;
+    for (auto &job : jobs)
+        for (SubtaskTimer *timer : job->timers)
+            cancelAndDelete(timer);
+    for (auto &job : freeJobs)
+        for (SubtaskTimer *timer : job->timers)
+            cancelAndDelete(timer);
 }
 
 /*
  * Function: broadcastGossip
  * -------------------------
- *   This function creates a gossip message that contains the current server scores.
- *   The message format is: <timestamp>:<module path>:<score1,score2,...>
- *   The gossip message is then sent through every available gossip gate (clientOut).
- *   This facilitates the exchange of server rating information among clients.
+ *   This function creates a GossipScores message that contains the current server scores
+ *   as an integer vector, indexed by 0-indexed server index, tagged with this client's id and
+ *   a fresh sequence number. The message is sent to 'gossipFanout' random gossip peers
+ *   (see sendGossip); they spread it further. This facilitates the exchange of server rating
+ *   information among clients.
  */
 void Client::broadcastGossip() {
-    // Get current simulation time.
-    simtime_t now = simTime();
-    stringstream ss;
-    ss << now.dbl() << ":" << getFullPath() << ":";
-
-    // Append each server score to the gossip string.
-    for (int i = 0; i < (int)serverScores.size(); i++) {
-       ss << serverScores[i];
-       if (i < (int)serverScores.size() - 1)
-          ss << ",";
+    // Log the scores being shared for debugging purposes.
+    if (logEnabled(LOG_INFO)) {
+        stringstream ss;
+        ss << simTime().dbl() << ":" << getFullPath() << ":";
+        for (int i = 0; i < (int)serverScores.size(); i++) {
+           ss << serverScores[i];
+           if (i < (int)serverScores.size() - 1)
+              ss << ",";
+        }
+        EV << "Broadcasting gossip: " << ss.str() << "\n";
+        logToFile("Broadcasting gossip: " + ss.str());
     }
-    string gossipStr = ss.str();
 
-    // Log the gossip message for debugging purposes.
-    EV << "Broadcasting gossip: " << gossipStr << "\n";
-    logToFile("Broadcasting gossip: " + gossipStr);
+    // Create the gossip message carrying the raw score vector.
+    GossipScores *gossipMsg = gossipPool.acquire("Gossip");
+    gossipMsg->setClientId(getId());
+    gossipMsg->setClientIndex(getIndex());
+    gossipMsg->setSequence(++gossipSequence);
+    gossipMsg->setTtl(gossipTtl);
+    gossipMsg->setScoresArraySize(serverScores.size());
+    for (int i = 0; i < (int)serverScores.size(); i++)
+       gossipMsg->setScores(i, serverScores[i]);
+    scoresChanged = false;
 
-    // Create the gossip message and add parameters.
-    cMessage *gossipMsg = new cMessage("Gossip");
-    gossipMsg->addPar("scores") = gossipStr.c_str();
-    gossipMsg->addPar("clientId") = getId();
+    // Remember our own gossip so that copies coming back around are not forwarded again.
+    seenGossip.checkAndInsert(DigestCache::digestOf(getId(), gossipSequence));
+    sendGossip(gossipMsg);
+}
 
-    // Determine the number of output gates dedicated to gossip.
+/*
+ * Function: sendGossip
+ * --------------------
+ *   Sends a copy of the gossip message to 'gossipFanout' distinct peers picked at random
+ *   among the clientOut[] gates (all of them if there are fewer), then returns the message to
+ *   the gossip pool. The copies are taken from the pool as well.
+ */
+void Client::sendGossip(GossipScores *gossipMsg) {
     int numGossipGates = gateSize("clientOut");
-    for (int i = 0; i < numGossipGates; i++) {
-         send(gossipMsg->dup(), "clientOut", i);
+    gossipPeers.resize(numGossipGates);
+    for (int i = 0; i < numGossipGates; i++)
+       gossipPeers[i] = i;
+    // Partial Fisher-Yates shuffle: the first 'fanout' entries are a random sample.
+    int fanout = min(gossipFanout, numGossipGates);
+    // Payload of one copy: the four header fields and the 32-bit scores.
+    long bytes = 4 + 4 + 8 + 4 + 4 * (long)gossipMsg->getScoresArraySize();
+    for (int i = 0; i < fanout; i++) {
+       int j = intuniform(i, numGossipGates - 1);
+       swap(gossipPeers[i], gossipPeers[j]);
+       send(gossipPool.copyOf(*gossipMsg), "clientOut", gossipPeers[i]);
+       emit(gossipBytesSignal, bytes);
+    }
+    gossipPool.release(gossipMsg);
+}
+
+/*
+ * Function: mergeGossip
+ * ---------------------
+ *   Folds a score vector received by gossip into gossipReputation according to the
+ *   'reputationMerge' rule. In AVERAGE mode only the newest vector of each peer counts
+ *   (copies may arrive out of order over different gossip paths), and the per-server sums
+ *   are updated incrementally by replacing that peer's previous contribution.
+ */
+void Client::mergeGossip(const GossipScores *gossip) {
+    int peer = gossip->getClientIndex();
+    int n = min((int)gossip->getScoresArraySize(), totalServers);
+    switch (reputationMerge) {
+    case MERGE_AVERAGE: {
+        if (peer < 0 || peer >= totalClients || gossip->getSequence() <= peerSequence[peer])
+            return;
+        if (peerSequence[peer] == 0)
+            knownPeers++;
+        peerSequence[peer] = gossip->getSequence();
+        int32_t *latest = &peerScores[(size_t)peer * totalServers];
+        for (int i = 0; i < n; i++) {
+            gossipReputation[i] += gossip->getScores(i) - latest[i];
+            latest[i] = gossip->getScores(i);
+        }
+        break;
+    }
+    case MERGE_MAX:
+        for (int i = 0; i < n; i++)
+            gossipReputation[i] = max(gossipReputation[i], (double)gossip->getScores(i));
+        break;
+    case MERGE_DECAY:
+        for (int i = 0; i < n; i++)
+            gossipReputation[i] = mergedVectors == 0 ? gossip->getScores(i)
+                : reputationDecay * gossipReputation[i] + (1 - reputationDecay) * gossip->getScores(i);
+        break;
     }
-    delete gossipMsg;
+    mergedVectors++;
+    reputationKnown = true;
 }
 
 /*
- * Function: getTopServers
+ * Function: reputationOf
+ * ----------------------
+ *   Combines the client's own score of a server with the merged gossip using the same
+ *   rule; with no gossip merged yet this is simply the own score.
+ */
+double Client::reputationOf(int serverIndex) const {
+    double own = serverScores[serverIndex];
+    if (mergedVectors == 0)
+        return own;
+    switch (reputationMerge) {
+    case MERGE_AVERAGE:
+        return (own + gossipReputation[serverIndex]) / (1 + knownPeers);
+    case MERGE_MAX:
+        return max(own, gossipReputation[serverIndex]);
+    case MERGE_DECAY:
+    default:
+        return reputationDecay * gossipReputation[serverIndex] + (1 - reputationDecay) * own;
+    }
+}
+
+/*
+ * Function: cancelReplicas
+ * ------------------------
+ *   After a subtask is decided before all of its replicas answered (by early quorum, or
+ *   because hedged or retried replicas made up the responses it needed), tells every server
+ *   the subtask was sent to but that has not responded yet to drop the request, so it does
+ *   not spend time on work nobody waits for.
+ *   With GUIDED partitioning the cancelled servers are idle again and pull new work.
+ */
+void Client::cancelReplicas(Job &job, int subtaskId) {
+    int cancels = 0;
+    chosenServers.clear();
+    for (int serverIndex : job.responses[subtaskId].assigned) {
+       if (hasResponded(job, subtaskId, serverIndex))
+          continue;
+       if (partitioning == PARTITION_GUIDED && job.serverChunk[serverIndex] == subtaskId) {
+          job.serverChunk[serverIndex] = -1;
+          chosenServers.push_back(serverIndex);
+       }
+       sendCancel(job, subtaskId, serverIndex);
+       cancels++;
+    }
+    emit(cancelsSentSignal, cancels);
+    if (logEnabled(LOG_DEBUG))
+       logToFile("Job " + to_string(job.id) + " Subtask_" + to_string(subtaskId) + " decided early; cancelled " + to_string(cancels) + " replicas", LOG_DEBUG);
+    for (int serverIndex : chosenServers)
+       pullWork(job, serverIndex);
+}
+
+/*
+ * Function: sendCancel
+ * --------------------
+ *   Withdraws the request of one replica: a request still waiting in an unsent batch is
+ *   simply taken out again, otherwise the server is sent a SubtaskCancel.
+ */
+void Client::sendCancel(Job &job, int subtaskId, int serverIndex) {
+    serverLoad.outstanding[serverIndex]--;   // A response that still arrives is ignored (see handleResult).
+    if (batchRequests && removeFromBatch(job, subtaskId, serverIndex))
+       return;
+    SubtaskCancel *cancel = new SubtaskCancel("Cancel");
+    cancel->setJobId(job.id);
+    cancel->setSubtaskId(subtaskId);
+    cancel->setRound(job.round);
+    send(cancel, "out", gateOf(serverIndex));
+}
+
+/*
+ * Function: outstandingReplicas
+ * -----------------------------
+ *   Replicas of a subtask that may still answer (sent, not answered and not given up on),
+ *   plus, with GUIDED partitioning, those not assigned to a server yet.
+ */
+int Client::outstandingReplicas(const Job &job, int subtaskId) const {
+    const SubtaskVotes &votes = job.responses[subtaskId];
+    return (int)votes.assigned.size() - (int)votes.size() - votes.abandoned + job.replicasNeeded[subtaskId];
+}
+
+/*
+ * Function: decideSubtask
  * -----------------------
- *   Sorts the serverScores vector in descending order (while keeping track of the original 0-indexed server indices)
- *   and selects the top (totalServers/2 + 1) servers.
+ *   Called whenever a response arrives or replicas are given up. A subtask is decided once
+ *   it has the responses it needs or nothing more can arrive; extra (hedged or retried)
+ *   replicas still outstanding at that point are cancelled.
+ *   In early-quorum mode, it is decided as soon as the replicas that can still count cannot
+ *   change the majority any more.
+ *   In witness mode the largest verified value wins; if nothing could be verified once all
+ *   replicas are in, another server is asked.
+ *   With adaptive replication the most likely correct value wins once the chance that it is
+ *   wrong is at most targetErrorRate (with earlyQuorum, possibly before all replicas are in).
+ *   Otherwise, once all replicas are in, more servers are asked (see escalateSubtask), and
+ *   when no more may be asked the plain majority decides.
+ */
+void Client::decideSubtask(Job &job, int subtaskId) {
+    SubtaskVotes &votes = job.responses[subtaskId];
+    int outstanding = outstandingReplicas(job, subtaskId);
+    bool complete = (int)votes.size() >= votes.needed || outstanding == 0;
+    if (verifyWitness) {
+        if (!complete)
+            return;
+        int winner = verifiedWinner(votes);
+        if (winner >= 0) {
+            finalizeSubtask(job, subtaskId, winner);
+            if (outstanding > 0)
+                cancelReplicas(job, subtaskId);
+        } else if (outstanding > 0) {
+            return;   // A hedged or retried replica may still bring a verified result.
+        } else if (reassignSubtask(job, subtaskId)) {
+            votes.needed = votes.size() + 1;
+        } else {
+            finalizeSubtask(job, subtaskId, majorityVote(votes));   // No server left to ask.
+        }
+    } else if (adaptiveReplication) {
+        if (!complete && !earlyQuorum)
+            return;
+        double agree, other;
+        int winner = weighVotes(votes, agree, other);
+        if (winner >= 0 && other <= targetErrorRate * (agree + other)) {
+            finalizeSubtask(job, subtaskId, winner);
+            if (outstanding > 0)
+                cancelReplicas(job, subtaskId);
+        } else if (!complete || escalateSubtask(job, subtaskId, agree, other)) {
+            return;
+        } else {
+            finalizeSubtask(job, subtaskId, majorityVote(votes));
+            if (outstanding > 0)
+                cancelReplicas(job, subtaskId);
+        }
+    } else if (complete) {
+        finalizeSubtask(job, subtaskId, majorityVote(votes));
+        if (outstanding > 0)
+            cancelReplicas(job, subtaskId);
+    } else if (earlyQuorum) {
+        int winner = majorityVote(votes, min(outstanding, votes.needed - (int)votes.size()));
+        if (winner >= 0) {
+            finalizeSubtask(job, subtaskId, winner);
+            cancelReplicas(job, subtaskId);
+        }
+    }
+}
+
+/*
+ * Function: armTimer
+ * ------------------
+ *   Schedules the subtask's timer for the earliest of its hedge time (hedgeDelay after its
+ *   first request, if it has not been hedged yet) and the timeouts of its outstanding
+ *   replicas. Nothing is scheduled when neither timeouts nor hedging are enabled.
+ */
+void Client::armTimer(Job &job, int subtaskId) {
+    if (subtaskTimeout == SIMTIME_ZERO && hedgeDelay == SIMTIME_ZERO)
+        return;
+    const SubtaskVotes &votes = job.responses[subtaskId];
+    simtime_t deadline = SIMTIME_MAX;
+    if (hedgeDelay > SIMTIME_ZERO && !votes.hedged && !votes.sentAt.empty())
+        deadline = votes.sentAt[0] + hedgeDelay;
+    if (subtaskTimeout > SIMTIME_ZERO) {
+        simtime_t timeout = timeoutFor(votes.attempt);
+        for (size_t i = 0; i < votes.assigned.size(); i++)
+            if (!hasResponded(job, subtaskId, votes.assigned[i]))
+                deadline = min(deadline, votes.sentAt[i] + timeout);
+    }
+    if ((int)job.timers.size() <= subtaskId)
+        job.timers.resize(subtaskId + 1, nullptr);
+    SubtaskTimer *&timer = job.timers[subtaskId];
+    if (!timer)
+        timer = new SubtaskTimer("SubtaskTimer");
+    else
+        cancelEvent(timer);
+    if (deadline == SIMTIME_MAX)
+        return;
+    timer->setJobId(job.id);
+    timer->setSubtaskId(subtaskId);
+    timer->setRound(job.round);
+    scheduleAt(max(deadline, simTime()), timer);
+}
+
+/*
+ * Function: subtaskTimedOut
+ * -------------------------
+ *   Handles a subtask timer:
+ *     - Hedging: if the subtask is still short of responses 'hedgeDelay' after its first
+ *       request, one extra replica is sent to another server; the first responses decide.
+ *     - Timeout: replicas that have not answered within the current timeout are given up
+ *       and cancelled (a response arriving later is ignored). Each one is replaced by a
+ *       request to another server while the subtask has had at most 'maxRetries' timeouts;
+ *       every timeout multiplies the next one by 'retryBackoff'.
+ *   A subtask whose replicas are all lost is then decided on the responses it has.
+ */
+void Client::subtaskTimedOut(SubtaskTimer *timer) {
+    Job *job = findJob(timer->getJobId());
+    int subtaskId = timer->getSubtaskId();
+    if (!job || job->done || timer->getRound() != job->round || job->subtaskStates[subtaskId] != SUBTASK_PENDING)
+        return;
+    SubtaskVotes &votes = job->responses[subtaskId];
+    simtime_t now = simTime();
+
+    if (hedgeDelay > SIMTIME_ZERO && !votes.hedged && (int)votes.size() < votes.needed
+        && now >= votes.sentAt[0] + hedgeDelay) {
+        votes.hedged = true;
+        if (reassignSubtask(*job, subtaskId))
+            emit(hedgesSentSignal, 1);
+    }
+
+    if (subtaskTimeout > SIMTIME_ZERO) {
+        simtime_t timeout = timeoutFor(votes.attempt);
+        int lost = 0;
+        for (size_t i = 0; i < votes.assigned.size(); i++) {
+            int serverIndex = votes.assigned[i];
+            if (hasResponded(*job, subtaskId, serverIndex) || votes.sentAt[i] + timeout > now)
+                continue;
+            markResponded(*job, subtaskId, serverIndex);   // A late response is dropped as a duplicate.
+            votes.abandoned++;
+            sendCancel(*job, subtaskId, serverIndex);
+            lost++;
+        }
+        if (lost > 0) {
+            emit(timeoutsSignal, lost);
+            votes.attempt++;
+            logToFile("Job " + to_string(job->id) + " Subtask_" + to_string(subtaskId) + ": " + to_string(lost)
+                      + " replicas timed out (attempt " + to_string(votes.attempt) + ")");
+            for (int k = 0; k < lost && votes.attempt <= maxRetries; k++) {
+                if (!reassignSubtask(*job, subtaskId))
+                    break;
+                emit(retriesSentSignal, 1);
+            }
+        }
+    }
+
+    decideSubtask(*job, subtaskId);
+    if (job->subtaskStates[subtaskId] == SUBTASK_PENDING)
+        armTimer(*job, subtaskId);
+    if (roundComplete(*job))
+        completeRound(*job);
+}
+
+/*
+ * Function: refreshHedgeDelay
+ * ---------------------------
+ *   Sets hedgeDelay to the 'hedgePercentile' of the recent replica latencies, once enough
+ *   of them have been seen.
+ */
+void Client::refreshHedgeDelay() {
+    if (hedgePercentile == 0 || replicaLatencies.size() < HEDGE_MIN_SAMPLES)
+        return;
+    latencyScratch = replicaLatencies;
+    sort(latencyScratch.begin(), latencyScratch.end());
+    hedgeDelay = nearestRank(latencyScratch, hedgePercentile);
+}
+
+/*
+ * Function: checkWitness
+ * ----------------------
+ *   Verifies a witness against the client's own copy of the subtask in O(1): the reported
+ *   maximum must occur at the witnessed position. This proves the value is an element of
+ *   the subtask (so it cannot be invented), though not that it is the largest one; that is
+ *   left to the spot checks.
+ */
+bool Client::checkWitness(const Job &job, int subtaskId, const KernelResult &result, int witness) const {
+    const SubtaskData &data = job.chunks[subtaskId];
+    return result.size() == 1 && witness >= 0 && witness < (int)data.size() && data[witness] == result[0];
+}
+
+/*
+ * Function: verifiedWinner
+ * ------------------------
+ *   Every verified value is an element of the subtask, so none exceeds its maximum and the
+ *   largest one is correct as soon as a single honest replica answered.
  *
  *   Returns:
- *      A vector of 0-indexed server indices corresponding to the top servers.
+ *      The position in 'votes' of the largest verified result, or -1 if none is verified.
+ */
+int Client::verifiedWinner(const SubtaskVotes &votes) const {
+    int best = -1;
+    for (int i = 0; i < (int)votes.size(); i++)
+       if (votes.verified[i] && (best < 0 || votes.results[i] > votes.results[best]))
+          best = i;
+    return best;
+}
+
+/*
+ * Function: spotCheckProbability
+ * ------------------------------
+ *   spotCheckRate for a server without score, falling as 1 / (1 + score) with every result
+ *   the server got right, but never below spotCheckMin.
+ */
+double Client::spotCheckProbability(int serverIndex) const {
+    return max(spotCheckMin, spotCheckRate / (1 + max(0, serverScores[serverIndex])));
+}
+
+/*
+ * Function: honestyOf
+ * -------------------
+ *   Estimated probability that a response of the server is correct: the share of its
+ *   responses that agreed with the decided result, starting from 'priorHonesty' as if the
+ *   server had two earlier responses of that quality.
  */
-vector<int> Client::getTopServers() {
-    vector<pair<int, int>> scorePairs;
+double Client::honestyOf(int serverIndex) const {
+    int agreed = serverScores[serverIndex];
+    return (agreed + 2 * priorHonesty) / (agreed + serverDisagreements[serverIndex] + 2);
+}
 
-    // Build pairs of (score, index) for each server.
-    for (int i = 0; i < (int)serverScores.size(); i++){
-       scorePairs.push_back({serverScores[i], i});
+/*
+ * Function: weighVotes
+ * --------------------
+ *   Honest servers all compute the same value, so at most one of the distinct values among
+ *   the responses is correct. The likelihood that a value is the correct one is the product
+ *   of honestyOf() over its supporters and of (1 - honestyOf()) over everyone else; that
+ *   nothing is correct, the product of (1 - honestyOf()) over all responses.
+ *
+ *   Returns:
+ *      The position in 'votes' of a response with the most likely value (-1 without
+ *      responses). 'agree' is that value's likelihood and 'other' the sum of the other
+ *      values' and of the all-wrong likelihood, so other / (agree + other) is the chance
+ *      that the value is wrong.
+ */
+int Client::weighVotes(const SubtaskVotes &votes, double &agree, double &other) const {
+    int n = votes.size();
+    double total = 1;
+    for (int i = 0; i < n; i++)
+        total *= 1 - honestyOf(votes.servers[i]);
+    int winner = -1;
+    agree = 0;
+    for (int i = 0; i < n; i++) {
+        bool seen = false;
+        for (int j = 0; j < i && !seen; j++)
+            seen = votes.results[j] == votes.results[i];
+        if (seen)
+            continue;
+        double likelihood = 1;
+        for (int j = 0; j < n; j++) {
+            double honesty = honestyOf(votes.servers[j]);
+            likelihood *= votes.results[j] == votes.results[i] ? honesty : 1 - honesty;
+        }
+        total += likelihood;
+        if (likelihood > agree) {
+            agree = likelihood;
+            winner = i;
+        }
     }
+    other = total - agree;
+    return winner;
+}
 
-    // Sort the pair vector in descending order by score.
-    sort(scorePairs.begin(), scorePairs.end(), greater<pair<int,int>>());
+/*
+ * Function: chooseAdaptiveReplicas
+ * --------------------------------
+ *   Appends servers picked by the replica selection policy to 'chosen', one at a time,
+ *   assuming each one will agree with the leading value: its likelihood 'agree' is
+ *   multiplied by the server's honesty and 'other' by the complement. Stops once the
+ *   leading value would be wrong with at most targetErrorRate, once the subtask has the
+ *   replicationFactor replicas of fixed replication, or when no linked server is left.
+ *   A new subtask starts with agree = other = 1.
+ */
+void Client::chooseAdaptiveReplicas(vector<int> &chosen, double agree, double other) {
+    while ((int)chosen.size() < replicationFactor && other > targetErrorRate * (agree + other)) {
+        size_t before = chosen.size();
+        selector->select(serverLoad, 1, getRNG(0), chosen);
+        if (chosen.size() == before)
+            break;
+        double honesty = honestyOf(chosen.back());
+        agree *= honesty;
+        other *= 1 - honesty;
+    }
+}
 
-    // Determine how many top servers are needed.
-    int num = totalServers / 2 + 1;
-    vector<int> top;
-    for (int i = 0; i < num && i < (int)scorePairs.size(); i++){
-       top.push_back(scorePairs[i].second);
+/*
+ * Function: escalateSubtask
+ * -------------------------
+ *   Adaptive replication: when all responses of a subtask are in but its leading value is
+ *   still too likely to be wrong, sends it to as many further servers as the target error
+ *   rate needs (see chooseAdaptiveReplicas) and waits for them.
+ *
+ *   Returns:
+ *      false if the subtask already has replicationFactor replicas or no server is left.
+ */
+bool Client::escalateSubtask(Job &job, int subtaskId, double agree, double other) {
+    SubtaskVotes &votes = job.responses[subtaskId];
+    size_t before = votes.assigned.size();
+    if (votes.size() == 0)
+        agree = other = 1;   // Every replica was lost: start over.
+    chooseAdaptiveReplicas(votes.assigned, agree, other);
+    int added = votes.assigned.size() - before;
+    if (added == 0)
+        return false;
+    const SubtaskRequest *msg = prepareRequest(job, subtaskId);
+    for (size_t i = before; i < votes.assigned.size(); i++) {
+        int serverIndex = votes.assigned[i];
+        votes.sentAt.push_back(simTime());
+        dispatchRequest(msg, serverIndex);
+        if (batchRequests && batchTimeout == SIMTIME_ZERO)
+            flushBatch(linkOf(serverIndex));
+        job.serverWork += job.chunks[subtaskId].size();
     }
-    return top;
+    votes.needed = votes.size() + added;
+    emit(escalationsSignal, added);
+    if (logEnabled(LOG_DEBUG))
+        logToFile("Job " + to_string(job.id) + " Subtask_" + to_string(subtaskId) + ": responses inconclusive, sent to "
+                  + to_string(added) + " more servers", LOG_DEBUG);
+    armTimer(job, subtaskId);
+    return true;
+}
+
+/*
+ * Function: reassignSubtask
+ * -------------------------
+ *   Sends a subtask to a linked server it has not been sent to yet in this round, chosen at
+ *   random: when none of its responses could be verified, as a hedge, or as a retry.
+ *
+ *   Returns:
+ *      false if every linked server has already been asked.
+ */
+bool Client::reassignSubtask(Job &job, int subtaskId) {
+    vector<int> &assigned = job.responses[subtaskId].assigned;
+    vector<int> &candidates = candidateScratch;
+    candidates.clear();
+    for (int serverIndex : linkedServers)
+       if (find(assigned.begin(), assigned.end(), serverIndex) == assigned.end())
+          candidates.push_back(serverIndex);
+    if (candidates.empty())
+       return false;
+    int serverIndex = candidates[intuniform(0, candidates.size() - 1)];
+    if (logEnabled(LOG_DEBUG))
+       logToFile("Job " + to_string(job.id) + " Subtask_" + to_string(subtaskId)
+                 + ": no verified result, resending to Server with index " + to_string(serverIndex), LOG_DEBUG);
+    assigned.push_back(serverIndex);
+    job.responses[subtaskId].sentAt.push_back(simTime());
+    if (partitioning == PARTITION_GUIDED && job.serverChunk[serverIndex] < 0)
+       job.serverChunk[serverIndex] = subtaskId;
+    dispatchRequest(prepareRequest(job, subtaskId), serverIndex);
+    if (batchRequests && batchTimeout == SIMTIME_ZERO)
+       flushBatch(linkOf(serverIndex));
+    job.serverWork += job.chunks[subtaskId].size();
+    armTimer(job, subtaskId);
+    return true;
+}
+
+/*
+ * Function: serverAnswered
+ * ------------------------
+ *   Updates the load the replica selection policy sees when a server answers (one request or
+ *   a whole batch) and piggybacks its current queue length, and folds the service rate it
+ *   reports into its speed estimate (an exponentially weighted average). The outstanding
+ *   count is left to handleResult, which knows whether a replica was already cancelled.
+ */
+void Client::serverAnswered(int serverIndex, int queueLength, double serviceRate) {
+    // The response carries the server's 0-indexed position in s[].
+    if (serverIndex < 0 || serverIndex >= totalServers)
+        throw cRuntimeError("Response from unknown server index %d", serverIndex);
+    serverLoad.queueLength[serverIndex] = queueLength;
+    if (serviceRate <= 0)
+        return;   // Served from a cache, so nothing was measured.
+    double &speed = serverSpeed[serverIndex];
+    if (speed > 0) {
+        speedSum -= speed;
+        speed += speedSmoothing * (serviceRate - speed);
+    } else {
+        speed = serviceRate;
+        measuredServers++;
+    }
+    speedSum += speed;
+}
+
+/*
+ * Function: dispatchRequest
+ * -------------------------
+ *   Sends a copy of the request (a recycled one if the pool has any) to the server, or, with
+ *   request batching, appends it to the
+ *   batch being filled for that server. A batch is sent as soon as it holds 'batchSize'
+ *   entries, when its 'batchTimeout' expires, or at the end of the round's dispatch.
+ */
+void Client::dispatchRequest(const SubtaskRequest *msg, int serverIndex) {
+    serverLoad.outstanding[serverIndex]++;
+    if (!batchRequests) {
+        send(requestPool.copyOf(*msg), "out", gateOf(serverIndex));
+        return;
+    }
+    int link = linkOf(serverIndex);
+    SubtaskBatch *&batch = pendingBatches[link];
+    if (!batch) {
+        batch = new SubtaskBatch("Batch");
+        batch->setPriority(requestPriority);
+        if (batchTimeout > SIMTIME_ZERO)
+            scheduleAt(simTime() + batchTimeout, batchTimers[link]);
+    }
+    BatchEntry entry;
+    entry.jobId = msg->getJobId();
+    entry.subtaskId = msg->getSubtaskId();
+    entry.round = msg->getRound();
+    entry.data = msg->getData();
+    entry.witness = msg->getWitness();
+    batch->appendEntries(entry);
+    if (batchSize > 0 && (int)batch->getEntriesArraySize() >= batchSize)
+        flushBatch(link);
+}
+
+/*
+ * Function: flushBatch
+ * --------------------
+ *   Sends the pending batch of linkedServers[link] and stops its timeout.
+ */
+void Client::flushBatch(int link) {
+    SubtaskBatch *batch = pendingBatches[link];
+    if (!batch)
+        return;
+    pendingBatches[link] = nullptr;
+    if (!batchTimers.empty())
+        cancelEvent(batchTimers[link]);
+    batchesSent++;
+    batchedRequests += batch->getEntriesArraySize();
+    if (logEnabled(LOG_DEBUG))
+        logToFile("Sending batch of " + to_string(batch->getEntriesArraySize()) + " requests to Server with index "
+                  + to_string(linkedServers[link]), LOG_DEBUG);
+    send(batch, "out", linkGates[link]);
+}
+
+void Client::flushBatches() {
+    for (int link = 0; link < (int)pendingBatches.size(); link++)
+        flushBatch(link);
+}
+
+/*
+ * Function: removeFromBatch
+ * -------------------------
+ *   Takes the request for (job, subtask) out of the batch still being filled for a server.
+ *
+ *   Returns:
+ *      true if the request was found there, false if it has already been sent.
+ */
+bool Client::removeFromBatch(const Job &job, int subtaskId, int serverIndex) {
+    int link = linkOf(serverIndex);
+    SubtaskBatch *batch = pendingBatches[link];
+    if (!batch)
+        return false;
+    for (size_t k = 0; k < batch->getEntriesArraySize(); k++) {
+        const BatchEntry &entry = batch->getEntries(k);
+        if (entry.jobId == job.id && entry.subtaskId == subtaskId && entry.round == job.round) {
+            batch->eraseEntries(k);
+            if (batch->getEntriesArraySize() == 0) {
+                delete batch;
+                pendingBatches[link] = nullptr;
+                if (!batchTimers.empty())
+                    cancelEvent(batchTimers[link]);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Function: buildServerLinks
+ * --------------------------
+ *   Follows each out[] gate to the server at its far end and records the links as a dense,
+ *   server-sorted pair of tables (linkedServers / linkGates), so gate and server indices
+ *   are translated without assuming out[i] leads to s[i]. Works for the full
+ *   NED mesh as well as for the sparse links created by the TopologyBuilder. A second
+ *   link to the same server is ignored. Under parallel simulation the far end may be the
+ *   placeholder of a server in another partition; only its name and index are read,
+ *   which placeholders carry as well.
+ *   With an aggregator tier the out[] gates lead to aggregators ("a[k]") instead, which are
+ *   recorded in aggregatorGates; a client talks either to servers or to aggregators.
+ */
+void Client::buildServerLinks() {
+    int numGates = gateSize("out");
+    vector<pair<int, int>> links;
+    aggregatorGates.clear();
+    for (int k = 0; k < numGates; k++) {
+        cModule *server = gate("out", k)->getPathEndGate()->getOwnerModule();
+        if (server && strcmp(server->getName(), "a") == 0) {
+            aggregatorGates.push_back(k);
+            continue;
+        }
+        int serverIndex = (server && strcmp(server->getName(), "s") == 0) ? server->getIndex() : -1;
+        if (serverIndex < 0 || serverIndex >= totalServers)
+            throw cRuntimeError("Gate out[%d] is not connected to a server", k);
+        links.push_back({serverIndex, k});
+    }
+    if (!aggregatorGates.empty()) {
+        if (!links.empty())
+            throw cRuntimeError("Client is connected to both servers and aggregators");
+        aggregatorOutstanding.assign(aggregatorGates.size(), 0);
+        return;
+    }
+    sort(links.begin(), links.end());
+    linkedServers.clear();
+    linkGates.clear();
+    for (auto &link : links) {
+        if (!linkedServers.empty() && linkedServers.back() == link.first)
+            continue;
+        linkedServers.push_back(link.first);
+        linkGates.push_back(link.second);
+    }
+    if (linkedServers.empty())
+        throw cRuntimeError("Client is not connected to any server");
+}
+
+/*
+ * Function: gateOf
+ * ----------------
+ *   Returns the out[] gate index leading to a linked server.
+ */
+int Client::gateOf(int serverIndex) const {
+    return linkGates[linkOf(serverIndex)];
+}
+
+/*
+ * Function: linkOf
+ * ----------------
+ *   Returns the position of a linked server in linkedServers (binary search).
+ */
+int Client::linkOf(int serverIndex) const {
+    auto it = lower_bound(linkedServers.begin(), linkedServers.end(), serverIndex);
+    if (it == linkedServers.end() || *it != serverIndex)
+        throw cRuntimeError("No link to server %d", serverIndex);
+    return it - linkedServers.begin();
+}
+
+/*
+ * Function: markResponded
+ * -----------------------
+ *   Records in the per-subtask bitset that a server has responded.
+ *
+ *   Returns:
+ *      false if the server had already responded for this subtask (duplicate response).
+ */
+bool Client::hasResponded(const Job &job, int subtaskId, int serverIndex) const {
+    return job.responded[(size_t)subtaskId * respondedWords + serverIndex / 64] & ((uint64_t)1 << (serverIndex % 64));
+}
+
+bool Client::markResponded(Job &job, int subtaskId, int serverIndex) {
+    uint64_t &word = job.responded[(size_t)subtaskId * respondedWords + serverIndex / 64];
+    uint64_t bit = (uint64_t)1 << (serverIndex % 64);
+    if (word & bit)
+        return false;
+    word |= bit;
+    return true;
+}
+
+/*
+ * Function: prepareRequest
+ * ------------------------
+ *   Fills the client's request template for the given subtask. The request only holds a handle
+ *   to the client's shared input buffer, so neither filling it nor copying it per replica
+ *   copies the subarray, and reusing the template saves an allocation per subtask.
+ *
+ *   Returns:
+ *      The template, named "Subtask_<id>"; valid until the next call. Only copies are sent.
+ */
+const SubtaskRequest *Client::prepareRequest(const Job &job, int subtaskId) {
+    SubtaskRequest *msg = requestTemplate;
+    msg->setName(("Subtask_" + to_string(subtaskId)).c_str());
+    msg->setJobId(job.id);
+    msg->setSubtaskId(subtaskId);
+    msg->setRound(job.round);
+    msg->setData(job.chunks[subtaskId]);
+    msg->setPriority(requestPriority);
+    msg->setWitness(verifyWitness);
+    msg->setReplicas(aggregatorGates.empty() ? 0 : replicationFactor);
+    return msg;
 }
 
 /*
  * Function: initialize
  * ----------------------
- *   This function is called once at the start of the simulation.
- *   It performs the following operations:
- *     1. Reads simulation parameters (totalServers, totalClients, arrayData).
- *     2. Logs initialization information.
- *     3. Builds a mapping from actual server module IDs to a 0-indexed array for score management.
- *     4. Reads and parses the input array, then divides it into subtasks.
- *     5. Randomly assigns each subtask to (n/2 + 1) servers.
- */
-void Client::initialize() {
-    currentRound = 1;
+ *   This function is called at the start of the simulation. Stage 0 is left to the
+ *   TopologyBuilder, which may still be creating this client's server links; in stage 1
+ *   the client performs the following operations:
+ *     1. Reads simulation parameters (totalServers, totalClients, arrayData/arrayFile, logLevel, operation).
+ *     2. Opens the log files and logs initialization information.
+ *     3. Finds the 0-indexed server behind each of its out[] gates.
+ *     4. Maps or parses the input array, then divides it into subtask views.
+ *     5. Starts the first job, which randomly assigns each subtask to (n/2 + 1) servers, and
+ *        schedules the arrival of the next one if the workload has more jobs.
+ */
+void Client::initialize(int stage) {
+    if (stage != 1)
+        return;
     totalServers = par("totalServers");
     totalClients = par("totalClients");
+    requestPriority = par("requestPriority");
+
+    // Open the buffered log files once; every later log call only queues a line.
+    logLevel = parseLogLevel(par("logLevel").stringValue());
+    if (logEnabled(LOG_ERROR)) {
+        logFile = FileLogger::acquire("client_" + to_string(getId()) + "_log.txt");
+        if (getEnvir()->getParsimNumPartitions() > 1)
+            outputFile = FileLogger::acquire("outputfile_p" + to_string(getEnvir()->getParsimProcId()) + ".txt");
+        else
+            outputFile = FileLogger::acquire("outputfile.txt");
+    }
 
     // Log initial configuration.
     stringstream initMsg;
@@ -147,257 +1360,492 @@ void Client::initialize() {
     EV << initMsg.str() << "\n";
     logToFile(initMsg.str());
 
-    // Prepare the server score vector.
-    serverScores.resize(totalServers, 0);
+    // Create the operation used to combine the subtask results; it must match the servers' one.
+    KernelParams kernelParams;
+    kernelParams.selectK = par("selectK");
+    kernelParams.histogramBins = par("histogramBins");
+    kernelParams.histogramMin = par("histogramMin");
+    kernelParams.histogramMax = par("histogramMax");
+    operation = createReductionOp(par("operation").stdstringValue(), kernelParams);
 
-    // Create mapping for server module IDs (assumes servers are named "s[0]", "s[1]", ... in the network)
+    // Prepare the server score vector. Each server's score trajectory is recorded as its own
+    // statistic "serverScore<index>", created from the serverScore statistic template.
+    serverScores.resize(totalServers, 0);
+    cProperty *scoreTemplate = getProperties()->get("statisticTemplate", "serverScore");
     for (int i = 0; i < totalServers; i++) {
-        cModule *serverModule = getParentModule()->getSubmodule("s", i);
-        if (serverModule) {
-            int actualId = serverModule->getId();
-            serverIdToIndex[actualId] = i;
-        }
+        string name = "serverScore" + to_string(i);
+        serverScoreSignals.push_back(registerSignal(name.c_str()));
+        if (scoreTemplate)
+            getEnvir()->addResultRecorders(this, serverScoreSignals[i], name.c_str(), scoreTemplate);
     }
+    replicaRttSignal = registerSignal("replicaRtt");
+    disagreeingVotesSignal = registerSignal("disagreeingVotes");
+    gossipBytesSignal = registerSignal("gossipBytes");
+    allocationsSignal = registerSignal("allocations");
+    requestTemplate = new SubtaskRequest("Subtask");
 
-    // Parse the input array from the "arrayData" parameter.
-    const char *arrayStr = par("arrayData").stringValue();
-    vector<int> array;
-    {
-       string s(arrayStr);
-       stringstream ss(s);
-       string token;
-       while (getline(ss, token, ',')) {
-           array.push_back(atoi(token.c_str()));
-       }
+    // Find the server behind each out[] gate (servers are named "s[0]", "s[1]", ... in the network).
+    // Only this module's own gates are inspected, so this is safe under parallel simulation.
+    buildServerLinks();
+
+    // Replica selection policy and the per-server load it works with.
+    selector = createReplicaSelector(par("replicaSelection").stdstringValue());
+    serverLoad.servers = linkedServers;
+    serverLoad.outstanding.assign(totalServers, 0);
+    serverLoad.queueLength.assign(totalServers, 0);
+    serverLoad.reputation.assign(totalServers, 0);
+    roundMakespanSignal = registerSignal("roundMakespan");
+
+    // Load the input array: memory-map the binary "arrayFile" if one is given, otherwise parse
+    // the "arrayData" parameter into a buffer. Either way all subtasks are views over it.
+    size_t x;
+    string arrayFile = par("arrayFile").stdstringValue();
+    if (!arrayFile.empty()) {
+       shared_ptr<const MappedArray> mapped = MappedArray::open(arrayFile);
+       arrayElements = mapped->data();
+       x = mapped->size();
+       arrayOwner = mapped;
+    } else {
+       shared_ptr<vector<int>> array = make_shared<vector<int>>();
+       parseArrayData(par("arrayData").stdstringValue(), *array);
+       arrayElements = array->data();
+       x = array->size();
+       arrayOwner = array;
     }
-    int n = totalServers;
-    int x = array.size();
-    if (x / n < 2) {
-       logToFile("Array size (" + to_string(x) + ") too small to divide into " + to_string(n) + " subtasks.");
+    arraySize = x;
+
+    // Partitioning: EQUAL cuts the subtasks once here, WEIGHTED and GUIDED every round.
+    const char *partitioningStr = par("partitioning").stringValue();
+    if (strcmp(partitioningStr, "equal") == 0)
+        partitioning = PARTITION_EQUAL;
+    else if (strcmp(partitioningStr, "weighted") == 0)
+        partitioning = PARTITION_WEIGHTED;
+    else if (strcmp(partitioningStr, "guided") == 0)
+        partitioning = PARTITION_GUIDED;
+    else
+        throw cRuntimeError("Unknown partitioning '%s' (expected equal, weighted or guided)", partitioningStr);
+    numSubtasks = par("numSubtasks");
+    if (numSubtasks < 0)
+        throw cRuntimeError("numSubtasks must not be negative, got %d", numSubtasks);
+    if (numSubtasks == 0)
+        numSubtasks = totalServers;
+    int minChunkSize = par("minChunkSize");
+    if (minChunkSize < 1)
+        throw cRuntimeError("minChunkSize must be at least 1, got %d", minChunkSize);
+    minChunk = minChunkSize;
+    guidedFraction = par("guidedFraction");
+    if (guidedFraction <= 0 || guidedFraction > 1)
+        throw cRuntimeError("guidedFraction must be within (0, 1], got %g", guidedFraction);
+    speedSmoothing = par("speedSmoothing");
+    if (speedSmoothing <= 0 || speedSmoothing > 1)
+        throw cRuntimeError("speedSmoothing must be within (0, 1], got %g", speedSmoothing);
+    serverSpeed.assign(totalServers, 0);
+    // Behind aggregators, each one caps the replicas at the size of its server group.
+    replicationFactor = aggregatorGates.empty() ? min(totalServers / 2 + 1, (int)linkedServers.size()) : totalServers / 2 + 1;
+
+    int n = numSubtasks;
+    SubtaskChunker chunker(arrayOwner, arrayElements, x, n);
+    size_t smallestChunk = partitioning == PARTITION_GUIDED ? x : chunker.minChunkSize();
+    if (smallestChunk < minChunk) {
+       logToFile("Array size (" + to_string(x) + ") too small to divide into " + to_string(n) + " subtasks.", LOG_ERROR);
        endSimulation();
     }
-    int subtaskSize = x / n;
     subtasks.clear();
-    for (int i = 0; i < n; i++) {
-       int start = i * subtaskSize;
-       int end = (i == n - 1) ? x : (i + 1) * subtaskSize;
-       vector<int> part(array.begin() + start, array.begin() + end);
-       subtasks.push_back(part);
+    if (partitioning == PARTITION_EQUAL)
+       for (int i = 0; i < n; i++)
+          subtasks.push_back(chunker.chunk(i));
+    respondedWords = (totalServers + 63) / 64;
+
+    // Witness verification replaces the (n/2 + 1)-fold replication the work is compared against.
+    string verification = par("verification").stdstringValue();
+    verifyWitness = verification == "witness";
+    if (!verifyWitness && verification != "none")
+        throw cRuntimeError("Unknown verification '%s' (expected none or witness)", verification.c_str());
+    if (verifyWitness && strcmp(operation->getName(), "max") != 0)
+        throw cRuntimeError("verification = \"witness\" requires operation \"max\", got \"%s\"", operation->getName());
+    spotCheckRate = par("spotCheckRate");
+    spotCheckMin = par("spotCheckMin");
+    if (verifyWitness && partitioning == PARTITION_GUIDED)
+        throw cRuntimeError("partitioning = \"guided\" cannot be combined with verification = \"witness\"");
+    baselineWork = (long)x * replicationFactor;
+
+    // Adaptive replication: replicationFactor becomes the most replicas a subtask gets.
+    string replication = par("replication").stdstringValue();
+    adaptiveReplication = replication == "adaptive";
+    if (!adaptiveReplication && replication != "fixed")
+        throw cRuntimeError("Unknown replication '%s' (expected fixed or adaptive)", replication.c_str());
+    targetErrorRate = par("targetErrorRate");
+    priorHonesty = par("priorHonesty");
+    if (targetErrorRate <= 0 || targetErrorRate >= 0.5)
+        throw cRuntimeError("targetErrorRate must be within (0, 0.5), got %g", targetErrorRate);
+    if (priorHonesty <= 0 || priorHonesty >= 1)
+        throw cRuntimeError("priorHonesty must be within (0, 1), got %g", priorHonesty);
+    if (adaptiveReplication && (verifyWitness || partitioning == PARTITION_GUIDED))
+        throw cRuntimeError("replication = \"adaptive\" cannot be combined with verification = \"witness\" "
+                            "or partitioning = \"guided\"");
+    serverDisagreements.assign(totalServers, 0);
+    replicasPerSubtaskSignal = registerSignal("replicasPerSubtask");
+    escalationsSignal = registerSignal("escalations");
+    wrongResultsSignal = registerSignal("wrongResults");
+    serverWorkSignal = registerSignal("serverWork");
+    workRatioSignal = registerSignal("workRatio");
+    liesDetectedSignal = registerSignal("liesDetected");
+    liesMissedSignal = registerSignal("liesMissed");
+    // Timeouts, retries and hedging.
+    subtaskTimeout = par("subtaskTimeout");
+    maxRetries = par("maxRetries");
+    retryBackoff = par("retryBackoff");
+    hedgePercentile = par("hedgePercentile");
+    if (subtaskTimeout < SIMTIME_ZERO)
+        throw cRuntimeError("subtaskTimeout must not be negative");
+    if (maxRetries < 0)
+        throw cRuntimeError("maxRetries must not be negative, got %d", maxRetries);
+    if (retryBackoff < 1)
+        throw cRuntimeError("retryBackoff must be at least 1, got %g", retryBackoff);
+    if (hedgePercentile < 0 || hedgePercentile > 100)
+        throw cRuntimeError("hedgePercentile must be within [0, 100], got %d", hedgePercentile);
+    hedgeDelay = SIMTIME_ZERO;
+    timeoutsSignal = registerSignal("timeouts");
+    retriesSentSignal = registerSignal("retriesSent");
+    hedgesSentSignal = registerSignal("hedgesSent");
+    subtasksFailedSignal = registerSignal("subtasksFailed");
+    subtaskFinalizedSignal = registerSignal("subtaskFinalized");
+    cancelsSentSignal = registerSignal("cancelsSent");
+    earlyQuorum = par("earlyQuorum");
+
+    // Behind an aggregator tier, replicas, voting and cancellation are the aggregators' job.
+    if (!aggregatorGates.empty()) {
+        if (verifyWitness || adaptiveReplication || partitioning != PARTITION_EQUAL || subtaskTimeout > SIMTIME_ZERO
+            || hedgePercentile > 0 || par("batchRequests").boolValue())
+            throw cRuntimeError("An aggregator tier requires partitioning = \"equal\", verification = \"none\", "
+                                "replication = \"fixed\", no subtaskTimeout or hedgePercentile, and no batchRequests");
     }
-    responses.clear();
-    responses.resize(n);
 
-    // For each subtask, randomly choose (n/2 + 1) servers and send the subtask.
-    int numServersPerSubtask = n / 2 + 1;
-    for (int i = 0; i < n; i++) {
-         stringstream dataStream;
-         for (int j = 0; j < (int)subtasks[i].size(); j++) {
-             dataStream << subtasks[i][j];
-             if (j != (int)subtasks[i].size() - 1)
-                dataStream << ",";
-         }
-         string msgName = "Subtask_" + to_string(i);
-         cMessage *msg = new cMessage(msgName.c_str());
-         msg->addPar("subtaskId") = i;
-         msg->addPar("data") = dataStream.str().c_str();
-         set<int> chosen;
-         while (chosen.size() < (unsigned)numServersPerSubtask) {
-             int r = intuniform(0, n - 1);
-             chosen.insert(r);
-         }
-         for (int serverIndex : chosen) {
-             // Reverse mapping: find the actual server module id for logging purposes.
-             int actualServerId = -1;
-             for (auto &entry : serverIdToIndex) {
-                 if (entry.second == serverIndex) {
-                     actualServerId = entry.first;
-                     break;
-                 }
-             }
-             stringstream ss;
-             ss << "Sending " << msgName << " to Server with index " << serverIndex
-                << " (module id " << actualServerId << ")";
-             EV << ss.str() << "\n";
-             logToFile(ss.str());
-             send(msg->dup(), "out", serverIndex);
-         }
-         delete msg;
+    // Request batching: one batch (and, with a timeout, one flush timer) per linked server.
+    batchRequests = par("batchRequests");
+    batchSize = par("batchSize");
+    batchTimeout = par("batchTimeout");
+    if (batchSize < 0)
+        throw cRuntimeError("batchSize must not be negative, got %d", batchSize);
+    if (batchRequests) {
+        pendingBatches.assign(linkedServers.size(), nullptr);
+        if (batchTimeout > SIMTIME_ZERO)
+            for (int link = 0; link < (int)linkedServers.size(); link++)
+                batchTimers.push_back(new cMessage("BatchTimeout", link));
+    }
+
+    // Gossip: periodic origination from a self-timer, duplicate suppression with a bounded digest table.
+    gossipInterval = par("gossipInterval");
+    gossipFanout = par("gossipFanout");
+    gossipTtl = par("gossipTtl");
+    seenGossip.resize(par("gossipDigestSlots").intValue());
+    if (gossipInterval > SIMTIME_ZERO) {
+        gossipTimer = new cMessage("GossipTimer");
+        scheduleAt(simTime() + gossipInterval, gossipTimer);
+    }
+
+    // Reputation merging of the received score vectors.
+    const char *merge = par("reputationMerge").stringValue();
+    if (strcmp(merge, "average") == 0)
+        reputationMerge = MERGE_AVERAGE;
+    else if (strcmp(merge, "max") == 0)
+        reputationMerge = MERGE_MAX;
+    else if (strcmp(merge, "decay") == 0)
+        reputationMerge = MERGE_DECAY;
+    else
+        throw cRuntimeError("Unknown reputationMerge '%s' (expected average, max or decay)", merge);
+    reputationDecay = par("reputationDecay");
+    if (reputationDecay < 0 || reputationDecay > 1)
+        throw cRuntimeError("reputationDecay must be within [0, 1], got %g", reputationDecay);
+    gossipReputation.assign(totalServers, 0);
+    if (reputationMerge == MERGE_AVERAGE) {
+        peerScores.assign((size_t)totalClients * totalServers, 0);
+        peerSequence.assign(totalClients, 0);
+    }
+    maliciousReplicasSignal = registerSignal("maliciousReplicas");
+
+    // Workload: the first job starts now, further ones arrive every 'jobInterarrival'.
+    numJobs = par("numJobs");
+    roundsPerJob = par("roundsPerJob");
+    if (roundsPerJob < 1)
+        throw cRuntimeError("roundsPerJob must be at least 1, got %d", roundsPerJob);
+    jobLatencySignal = registerSignal("jobLatency");
+    jobsInFlightSignal = registerSignal("jobsInFlight");
+    startJob();
+    if (numJobs == 0 || nextJobId < numJobs) {
+        jobArrivalTimer = new cMessage("JobArrival");
+        scheduleAt(simTime() + par("jobInterarrival").doubleValue(), jobArrivalTimer);
     }
 }
 
+/*
+ * Function: handleResult
+ * ----------------------
+ *   Processes one subtask result, whether it arrived alone (a returned SubtaskRequest) or as an entry
+ *   of a BatchResponse:
+ *     - Looks up the job and records the result under the sender's 0-indexed server index
+ *       (results for finished jobs, earlier rounds, subtasks that are no longer pending, and
+ *       duplicates are ignored).
+ *     - Logs the received result and current score state.
+ *     - Once the required number of responses for the subtask is received (or, with earlyQuorum,
+ *       once the majority is unbeatable), it finalizes the subtask (see decideSubtask and
+ *       finalizeSubtask), bumps the completed-subtask counter and cancels any outstanding replicas.
+ *     - When the counter reaches the number of subtasks, completeRound computes the final
+ *       result and starts the job's next round or completes the job.
+ */
+void Client::handleResult(int jobId, int round, int subtaskId, int senderIndex, int senderId, bool malicious, bool corrupted,
+                          KernelResult &&result, int witness) {
+    const char* serverType = malicious ? "Malicious" : "Honest";
+    Job *job = findJob(jobId);
+    if (!job || job->done || round != job->round || subtaskId < 0 || subtaskId >= (int)job->chunks.size()
+        || job->subtaskStates[subtaskId] != SUBTASK_PENDING || !markResponded(*job, subtaskId, senderIndex)) {
+        EV << "Client " << getId() << " ignoring late or duplicate response for Job " << jobId
+           << " Subtask_" << subtaskId << " from Server index " << senderIndex << "\n";
+        // A GUIDED server whose replica is no longer needed is idle all the same.
+        if (job && !job->done && round == job->round && partitioning == PARTITION_GUIDED
+            && job->serverChunk[senderIndex] == subtaskId) {
+            job->serverChunk[senderIndex] = -1;
+            pullWork(*job, senderIndex);
+        }
+        return;
+    }
+    // Every request is taken off the server's outstanding count once: here, or by sendCancel for
+    // a replica given up or no longer needed, whose late response is ignored above.
+    serverLoad.outstanding[senderIndex]--;
+    SubtaskVotes &votes = job->responses[subtaskId];
+    votes.servers.push_back(senderIndex);
+    votes.results.push_back(move(result));
+    votes.verified.push_back(verifyWitness && checkWitness(*job, subtaskId, votes.results.back(), witness));
+    votes.malicious.push_back(malicious);
+    votes.corrupted.push_back(corrupted);
+    if (malicious)
+        job->maliciousReplicas++;
+    size_t replica = find(votes.assigned.begin(), votes.assigned.end(), senderIndex) - votes.assigned.begin();
+    if (replica < votes.sentAt.size()) {
+        simtime_t latency = simTime() - votes.sentAt[replica];
+        emit(replicaRttSignal, latency);
+        if (hedgePercentile > 0) {
+            if (replicaLatencies.size() < LATENCY_WINDOW)
+                replicaLatencies.push_back(latency.dbl());
+            else
+                replicaLatencies[latencyCursor++ % LATENCY_WINDOW] = latency.dbl();
+        }
+    }
+    bool freed = partitioning == PARTITION_GUIDED && job->serverChunk[senderIndex] == subtaskId;
+    if (freed)
+        job->serverChunk[senderIndex] = -1;
+    if (verifyWitness && !votes.verified.back())
+        logToFile("Job " + to_string(job->id) + " Subtask_" + to_string(subtaskId) + ": rejected result of Server index "
+                  + to_string(senderIndex) + " (invalid witness " + to_string(witness) + ")");
+
+    // Log the received response details.
+    if (traceEnabled(LOG_INFO)) {
+        stringstream respMsg;
+        respMsg << "Received Response for Job " << job->id << " Subtask_" << subtaskId
+                << " from Server index " << senderIndex
+                << " (module id " << senderId << ", " << serverType
+                << ") with result = " << resultToString(votes.results.back());
+        EV << "Client " << getId() << " " << respMsg.str() << "\n";
+        logToFile(respMsg.str());
+    }
+
+    // Log the current server scores before processing the subtask.
+    if (logEnabled(LOG_DEBUG)) {
+        stringstream scoreMsg;
+        scoreMsg << "Current scores (before processing subtask " << subtaskId << "): ";
+        for (int i = 0; i < (int)serverScores.size(); i++) {
+            scoreMsg << "Server" << i << "=" << serverScores[i] << " ";
+        }
+        logToFile(scoreMsg.str(), LOG_DEBUG);
+    }
+
+    // When enough responses for the subtask are received, perform majority voting (see decideSubtask).
+    decideSubtask(*job, subtaskId);
+
+    // When all subtasks are finalized, compute the final result. Responses for finalized
+    // subtasks are dropped above, so this fires exactly once per round: on the response
+    // that finalizes the last subtask. Until then, a GUIDED server that is done pulls more work.
+    if (roundComplete(*job))
+        completeRound(*job);
+    else if (freed)
+        pullWork(*job, senderIndex);
+}
+
+/*
+ * Function: handleAggregateResult
+ * -------------------------------
+ *   Takes over a subtask decided by an aggregator: the vote summary is entered as the
+ *   subtask's responses (agreeing servers with the decided value, the others with an empty
+ *   one), so that finalizeSubtask updates the scores and statistics exactly as for a vote
+ *   the client ran itself. Results for finished jobs, earlier rounds or decided subtasks
+ *   are ignored.
+ */
+void Client::handleAggregateResult(const AggregateResult *agg) {
+    int link = find(aggregatorGates.begin(), aggregatorGates.end(), agg->getArrivalGate()->getIndex()) - aggregatorGates.begin();
+    if (link < (int)aggregatorOutstanding.size())
+        aggregatorOutstanding[link] = max(0, aggregatorOutstanding[link] - 1);
+    int subtaskId = agg->getSubtaskId();
+    Job *job = findJob(agg->getJobId());
+    if (!job || job->done || agg->getRound() != job->round || subtaskId < 0 || subtaskId >= (int)job->chunks.size()
+        || job->subtaskStates[subtaskId] != SUBTASK_PENDING) {
+        EV << "Client " << getId() << " ignoring late AggregateResult for Job " << agg->getJobId()
+           << " Subtask_" << subtaskId << "\n";
+        return;
+    }
+    SubtaskVotes &votes = job->responses[subtaskId];
+    KernelResult decided(agg->getResultArraySize());
+    for (size_t i = 0; i < decided.size(); i++)
+        decided[i] = agg->getResult(i);
+    int winner = -1;
+    for (size_t k = 0; k < agg->getVotesArraySize(); k++) {
+        const AggregateVote &vote = agg->getVotes(k);
+        if (vote.agreed && winner < 0)
+            winner = votes.size();
+        votes.servers.push_back(vote.serverIndex);
+        votes.results.push_back(vote.agreed ? decided : KernelResult());
+        votes.verified.push_back(false);
+        votes.malicious.push_back(vote.malicious);
+        votes.corrupted.push_back(vote.corrupted);
+        if (vote.malicious)
+            job->maliciousReplicas++;
+    }
+    job->serverWork += (long)job->chunks[subtaskId].size() * agg->getReplicas();
+    if (!votes.sentAt.empty())
+        emit(replicaRttSignal, simTime() - votes.sentAt[0]);
+    if (traceEnabled(LOG_INFO)) {
+        stringstream respMsg;
+        respMsg << "Received AggregateResult for Job " << job->id << " Subtask_" << subtaskId
+                << " from Aggregator " << agg->getAggregatorIndex() << " (" << votes.size() << " votes)"
+                << " with result = " << resultToString(decided);
+        EV << "Client " << getId() << " " << respMsg.str() << "\n";
+        logToFile(respMsg.str());
+    }
+    finalizeSubtask(*job, subtaskId, winner);
+    if (roundComplete(*job))
+        completeRound(*job);
+}
+
 /*
  * Function: handleMessage
  * -------------------------
- *   This function processes incoming messages. It handles two types of messages:
- *   1. "Response" messages from servers containing the computed result for a subtask.
- *   2. "Gossip" messages from other clients containing server score information.
+ *   This function processes incoming messages. It handles three types of messages:
+ *   1. Responses from servers: the SubtaskRequest sent, returned with the computed result.
+ *   2. BatchResponse messages from servers containing the results of a batch of subtasks.
+ *   3. AggregateResult messages from aggregators containing a subtask decided by their vote.
+ *   4. GossipScores messages from other clients containing server score information.
+ *   and four kinds of timers: the arrival of the next job, the periodic gossip, the subtask
+ *   timeouts / hedges and the batch timeouts.
  *
- *   For response messages, the client:
- *     - Updates the responses mapping using a 0-indexed server index.
- *     - Logs the received response and current score state.
- *     - Once the required number of responses for a subtask is received,
- *       it performs majority voting to determine the valid result, updates server scores,
- *       and logs the majority result.
- *     - When responses for all subtasks are received, it computes the final result and
- *       (if in Round 1) transitions to Round 2 by selecting the top servers based on scores.
+ *   Every result, single or batched, is passed to handleResult for voting. Returned requests
+ *   and received gossip are kept for reuse in the message pools instead of being deleted.
  *
- *   For gossip messages, the client logs the received score information.
+ *   For gossip messages, the client drops duplicates, logs the received score information,
+ *   merges it into the reputation estimate and forwards the gossip to random peers while its hop limit allows.
+ *
+ *   The gossip timer periodically originates gossip while jobs are running.
  */
 void Client::handleMessage(cMessage *msg) {
-    if (strcmp(msg->getName(), "Response") == 0) {
-       int subtaskId = msg->par("subtaskId");
-       int result = msg->par("result");
-       int actualSenderId = msg->par("serverId");
-       const char* serverType = msg->par("serverType").stringValue();
-       // Convert actual server module id to our 0-indexed server index.
-       int senderIndex = serverIdToIndex[actualSenderId];
-       responses[subtaskId][senderIndex] = result;
-
-       // Log the received response details.
-       stringstream respMsg;
-       respMsg << "Received Response for Subtask_" << subtaskId
-               << " from Server index " << senderIndex
-               << " (module id " << actualSenderId << ", " << serverType
-               << ") with result = " << result;
-       EV << "Client " << getId() << " " << respMsg.str() << "\n";
-       logToFile(respMsg.str());
-
-       // Log the current server scores before processing the subtask.
-       {
-           stringstream scoreMsg;
-           scoreMsg << "Current scores (before processing subtask " << subtaskId << "): ";
-           for (int i = 0; i < (int)serverScores.size(); i++) {
-               scoreMsg << "Server" << i << "=" << serverScores[i] << " ";
-           }
-           logToFile(scoreMsg.str());
+    AllocationProbe probe(this, allocationsSignal);
+    if (msg == jobArrivalTimer) {
+       // Open-loop arrivals: the next job comes regardless of how many are still in flight.
+       startJob();
+       if (numJobs == 0 || nextJobId < numJobs)
+          scheduleAt(simTime() + par("jobInterarrival").doubleValue(), jobArrivalTimer);
+    }
+    else if (msg == gossipTimer) {
+       // Share the scores if they changed; keep gossiping while jobs are still running.
+       if (scoresChanged)
+          broadcastGossip();
+       if (!allJobsDone())
+          scheduleAt(simTime() + gossipInterval, gossipTimer);
+    }
+    else if (SubtaskTimer *timer = dynamic_cast<SubtaskTimer *>(msg)) {
+       // Hedge or timeout of a subtask; the timer stays with its job for reuse.
+       subtaskTimedOut(timer);
+    }
+    else if (msg->isSelfMessage()) {
+       // Batch timeout: send whatever the batch of that server holds by now.
+       flushBatch(msg->getKind());
+    }
+    else if (SubtaskRequest *resp = dynamic_cast<SubtaskRequest *>(msg)) {
+       serverAnswered(resp->getServerIndex(), resp->getQueueLength(), resp->getServiceRate());
+       KernelResult result(resp->getResultArraySize());
+       for (int i = 0; i < (int)result.size(); i++)
+          result[i] = resp->getResult(i);
+       handleResult(resp->getJobId(), resp->getRound(), resp->getSubtaskId(), resp->getServerIndex(),
+                    resp->getServerId(), resp->getMalicious(), resp->getCorrupted(), move(result), resp->getWitnessPosition());
+       requestPool.release(resp);
+    }
+    else if (BatchResponse *batch = dynamic_cast<BatchResponse *>(msg)) {
+       // A coalesced response: every entry goes through the same voting path as a single response.
+       serverAnswered(batch->getServerIndex(), batch->getQueueLength(), batch->getServiceRate());
+       for (size_t k = 0; k < batch->getEntriesArraySize(); k++) {
+          const BatchResult &entry = batch->getEntries(k);
+          KernelResult result(entry.length);
+          for (int i = 0; i < entry.length; i++)
+             result[i] = batch->getResults(entry.offset + i);
+          handleResult(entry.jobId, entry.round, entry.subtaskId, batch->getServerIndex(),
+                       batch->getServerId(), batch->getMalicious(), entry.corrupted, move(result), entry.witness);
        }
-
-       // When enough responses for the subtask are received, perform majority voting.
-       if (responses[subtaskId].size() == (unsigned)(totalServers / 2 + 1)) {
-           map<int, int> freq;
-           for (auto &p : responses[subtaskId])
-              freq[p.second]++;
-           int majorityVal = 0, maxCount = 0;
-           for (auto &entry : freq) {
-               if (entry.second > maxCount) {
-                  maxCount = entry.second;
-                  majorityVal = entry.first;
-               } else if (entry.second == maxCount && entry.first > majorityVal) {
-                  majorityVal = entry.first;
-               }
-           }
-           subtaskResults[subtaskId] = majorityVal;
-
-           // Update scores: For every response matching the majority, increment the server's score.
-           for (auto &p : responses[subtaskId]) {
-              int idx = p.first;
-              if (p.second == majorityVal)
-                 serverScores[idx] += 1;
-           }
-
-           // Log updated scores after processing the subtask.
-           {
-               stringstream scoreMsg;
-               scoreMsg << "Updated scores after processing Subtask_" << subtaskId << ": ";
-               for (int i = 0; i < (int)serverScores.size(); i++) {
-                   scoreMsg << "Server" << i << "=" << serverScores[i] << " ";
-               }
-               EV << "Client " << getId() << " " << scoreMsg.str() << "\n";
-               logToFile(scoreMsg.str());
-           }
-
-           // Log the majority result for the subtask.
-           {
-              stringstream subtaskLog;
-              subtaskLog << "Subtask_" << subtaskId << " majority result = " << majorityVal;
-              logToFile(subtaskLog.str());
-           }
+       delete msg;
+    }
+    else if (AggregateResult *agg = dynamic_cast<AggregateResult *>(msg)) {
+       handleAggregateResult(agg);
+       delete msg;
+    }
+    else if (GossipScores *gossip = dynamic_cast<GossipScores *>(msg)) {
+       int senderClient = gossip->getClientId();
+       // Drop gossip we have already seen (our own included).
+       if (seenGossip.checkAndInsert(DigestCache::digestOf(senderClient, gossip->getSequence()))) {
+          gossipPool.release(gossip);
+          return;
+       }
+       if (logEnabled(LOG_INFO)) {
+          stringstream scoreStr;
+          for (int i = 0; i < (int)gossip->getScoresArraySize(); i++) {
+             scoreStr << gossip->getScores(i);
+             if (i < (int)gossip->getScoresArraySize() - 1)
+                scoreStr << ",";
+          }
+          stringstream gossipRecv;
+          gossipRecv << "Received gossip from Client " << senderClient << " with scores: " << scoreStr.str();
+          EV << "Client " << getId() << " " << gossipRecv.str() << "\n";
+          logToFile(gossipRecv.str());
+          writeOutput("Client " + to_string(getId()) + " received gossip from Client "
+                      + to_string(senderClient) + " with scores: " + scoreStr.str());
        }
 
-       // When responses for all subtasks are in, compute the final result.
-       if (responsesProcessed() == totalServers) {
-            int finalResult = 0;
-            for (auto &entry : subtaskResults)
-               finalResult = max(finalResult, entry.second);
-            stringstream finalMsg;
-            finalMsg << "Final Result in Round " << currentRound << " = " << finalResult;
-            EV << "Client " << getId() << " " << finalMsg.str() << "\n";
-            logToFile(finalMsg.str());
-
-            // Append final result to the common output file.
-            ofstream outfile("outputfile.txt", ios::app);
-            if (outfile.is_open()) {
-                outfile << "Client " << getId() << " Round " << currentRound
-                        << " Final Result = " << finalResult << "\n";
-                outfile.close();
-            }
+       mergeGossip(gossip);
 
-            // Transition to Round 2 if in Round 1.
-            if (currentRound == 1) {
-                currentRound = 2;
-                logToFile("Transitioning to Round 2. Selecting top servers based on current scores.");
-                vector<int> topServers = getTopServers();
-                stringstream round2Log;
-                round2Log << "Top servers selected for Round 2: ";
-                for (int sid : topServers)
-                    round2Log << "Server" << sid << " ";
-                logToFile(round2Log.str());
-                // Clear previous responses and majority results for round transition.
-                for (auto &m : responses)
-                    m.clear();
-                subtaskResults.clear();
-
-                // Resend the same subtasks in Round 2 to top-scoring servers.
-                int n = totalServers;
-                int numServersPerSubtask = n / 2 + 1;
-                for (int i = 0; i < n; i++) {
-                    stringstream dataStream;
-                    for (int j = 0; j < (int)subtasks[i].size(); j++){
-                       dataStream << subtasks[i][j];
-                       if (j != (int)subtasks[i].size() - 1)
-                          dataStream << ",";
-                    }
-                    string msgName = "Subtask_" + to_string(i);
-                    cMessage *msg = new cMessage(msgName.c_str());
-                    msg->addPar("subtaskId") = i;
-                    msg->addPar("data") = dataStream.str().c_str();
-                    set<int> chosen;
-                    int idx = 0;
-                    while (chosen.size() < (unsigned)numServersPerSubtask) {
-                       if (idx < (int)topServers.size())
-                          chosen.insert(topServers[idx]);
-                       else
-                          chosen.insert(intuniform(0, n - 1));
-                       idx++;
-                    }
-                    for (int serverIndex : chosen) {
-                        stringstream round2Msg;
-                        round2Msg << "Round 2: Sending " << msgName << " to Server " << serverIndex;
-                        logToFile(round2Msg.str());
-                        send(msg->dup(), "out", serverIndex);
-                    }
-                    delete msg;
-                }
-            }
+       // Epidemic spreading: pass new gossip on until its hop limit is used up.
+       if (gossip->getTtl() > 1) {
+          gossip->setTtl(gossip->getTtl() - 1);
+          sendGossip(gossip);
+       } else {
+          gossipPool.release(gossip);
        }
-       delete msg;
-    }
-    else if (strcmp(msg->getName(), "Gossip") == 0) {
-       const char* scoreStr = msg->par("scores").stringValue();
-       int senderClient = msg->par("clientId");
-       stringstream gossipRecv;
-       gossipRecv << "Received gossip from Client " << senderClient << " with scores: " << scoreStr;
-       EV << "Client " << getId() << " " << gossipRecv.str() << "\n";
-       logToFile(gossipRecv.str());
-       ofstream outfile("outputfile.txt", ios::app);
-       if (outfile.is_open()) {
-           outfile << "Client " << getId() << " received gossip from Client " << senderClient
-                   << " with scores: " << scoreStr << "\n";
-           outfile.close();
-       }
-       delete msg;
     }
     else {
        delete msg;
     }
 }
+
+/*
+ * Function: finish
+ * ----------------
+ *   Records the workload results: completed jobs and sustained throughput (completed jobs per
+ *   second between the first arrival and the last completion). The latency percentiles are
+ *   written by the jobLatency and subtaskFinalized statistics (record=percentiles).
+ */
+void Client::finish() {
+    if (batchRequests) {
+        recordScalar("batchesSent", batchesSent);
+        recordScalar("batchedRequests", batchedRequests);
+    }
+    recordScalar("jobsCompleted", jobsCompleted);
+    if (jobsCompleted == 0)
+        return;
+    simtime_t span = lastCompletion - firstArrival;
+    if (span > SIMTIME_ZERO)
+        recordScalar("throughput", jobsCompleted / span.dbl(), "1/s");
+}
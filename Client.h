@@ -9,103 +9,362 @@
 
 #include <omnetpp.h>
 #include <vector>
-#include <set>
+#include <deque>
+#include <memory>
 #include <map>
 #include <string>
+#include <cmath>
+#include "TaskMessages_m.h"
+#include "Logger.h"
+#include "ComputeKernels.h"
+#include "Voting.h"
+#include "DigestCache.h"
+#include "MappedArray.h"
+#include "ReplicaSelector.h"
+#include "MessagePool.h"
+#include "AllocationCounter.h"
 using namespace omnetpp;
 using namespace std;
 
 /**
- * ClientMessage
- * -------------
- * This is a custom message class used by the Client module to send integer array responses.
- * Each message contains:
- *   - 'arr': The integer array (or subarray) being processed.
- *   - 'arr_len': The length of the array.
- *   - 'ID': Identifier for the client sending the message.
- *   - 'time': A timestamp indicating when the message was created.
+ * SubtaskState
+ * ------------
+ * Life cycle of a subtask within a round:
+ *   PENDING   - waiting for replica responses,
+ *   QUORUM    - enough responses arrived (or, in early-quorum mode, the majority can no
+ *               longer be overturned) and the majority value has been decided,
+ *   FINALIZED - the result is recorded and the server scores are updated.
+ * Responses for subtasks that are no longer PENDING are ignored.
  */
-class ClientMessage : public cMessage {
-  public:
-    vector<int> arr;  // The integer array or subarray.
-    int arr_len;      // Length of the array.
-    int ID;           // Identifier of the sending client.
-    time_t time;      // Timestamp of message creation.
+enum SubtaskState {
+    SUBTASK_PENDING,
+    SUBTASK_QUORUM,
+    SUBTASK_FINALIZED
+};
+
+/**
+ * Job
+ * ---
+ * State of one job in flight: a run of all subtasks over the input array, in one or more
+ * rounds. Several jobs may be in flight at once; every message carries its job id.
+ * Job objects are recycled, so the per-subtask arrays keep their capacity across jobs.
+ */
+struct Job {
+    int id;                                       // Client-local job id (consecutive).
+    int round;                                    // Current round, 1..roundsPerJob.
+    bool done;                                    // All rounds completed.
+    simtime_t arrivalTime;                        // When the job arrived.
+    simtime_t roundStartTime;                     // When the current round's subtasks were sent.
+    vector<SubtaskData> chunks;                   // Subtasks of the current round (views of the input array).
+    vector<SubtaskVotes> responses;               // For each subtask, the responses received so far.
+    vector<uint64_t> responded;                   // Bitset per subtask: which server indices have responded.
+    vector<KernelResult> subtaskResults;          // Majority result for each subtask (indexed by subtask id).
+    vector<SubtaskState> subtaskStates;           // State of each subtask in the current round.
+    vector<simtime_t> finalizedAt;                // Time each subtask of the current round was finalized.
+    int completedSubtasks;                        // Number of FINALIZED subtasks in the current round.
+    int maliciousReplicas;                        // Responses from malicious servers in the current round.
+    long serverWork;                              // Elements sent to servers for computation in the current round.
+    int liesDetected;                             // Wrong responses rejected in the current round.
+    int liesMissed;                               // Wrong responses adopted as a subtask result in the current round.
+    int wrongResults;                             // Subtasks of the current round decided on a wrong value (as the servers report).
+    int failedSubtasks;                           // Subtasks of the current round left without any response.
+    vector<SubtaskTimer *> timers;                // Timeout / hedge timer of each subtask (created on first use).
+    vector<int> replicasNeeded;                   // GUIDED: replicas of each subtask not assigned yet.
+    vector<int> serverChunk;                      // GUIDED: subtask each server works on (-1 = idle), by server index.
+    size_t nextOffset;                            // Start of the part of the array not cut into subtasks yet.
+    int firstOpenChunk;                           // GUIDED: no subtask before this one needs more replicas.
 };
 
 /**
- * gossipMessage
+ * ReputationMerge
  * ---------------
- * This is a custom message class used for exchanging server scores (via gossip protocol)
- * between client nodes. The message contains:
- *   - 's': A string formatted as <timestamp>:<IP>:<score1,score2,...> representing the
- *          sender's score information.
+ * How the score vectors received by gossip are merged with the client's own scores into
+ * the reputation estimate used for Round 2 selection ('reputationMerge' parameter):
+ *   AVERAGE - mean of the own scores and the latest vector of every peer heard from,
+ *   MAX     - element-wise maximum of the own scores and every received vector,
+ *   DECAY   - exponentially decayed average of the received vectors (each new vector gets
+ *             weight 1 - reputationDecay), combined with the own scores the same way.
  */
-class gossipMessage : public cMessage {
-  public:
-    string s;  // Gossip message string.
+enum ReputationMerge {
+    MERGE_AVERAGE,
+    MERGE_MAX,
+    MERGE_DECAY
+};
+
+/**
+ * Partitioning
+ * ------------
+ * How the input array is cut into the subtasks of a round ('partitioning' parameter):
+ *   EQUAL    - 'numSubtasks' chunks of equal size, cut once at initialization,
+ *   WEIGHTED - 'numSubtasks' chunks cut every round in proportion to the learned speed of
+ *              the servers they are sent to, so that they all take about equally long,
+ *   GUIDED   - chunks cut on demand: whenever a server is idle it takes a chunk whose size
+ *              shrinks with the remaining array and grows with the server's speed.
+ * Server speeds are learned from the service rate every response reports.
+ */
+enum Partitioning {
+    PARTITION_EQUAL,
+    PARTITION_WEIGHTED,
+    PARTITION_GUIDED
 };
 
 /**
  * Client Module Class
  * ---------------------
  * The Client module performs the following tasks:
- * 1. Reads an input array (provided as a comma-separated string via the 'arrayData'
- *    parameter) and divides it into 'n' subtasks, where 'n' is the total number of server nodes.
- *    Each subtask has at least 2 elements.
- * 2. For each subtask, it randomly selects (n/2 + 1) servers to execute the subtask.
+ * 1. Reads an input array (a comma-separated string in the 'arrayData' parameter, or a binary
+ *    file memory-mapped from 'arrayFile') and divides it into subtasks, by default 'n' equal ones, where 'n' is the
+ *    total number of server nodes. Each subtask has at least 'minChunkSize' (2) elements. See Partitioning
+ *    for cutting it by server speed instead.
+ * 2. For each subtask, it selects (n/2 + 1) of the servers it is linked to (all of
+ *    them in the default full mesh, or those listed in the topology file) to execute the subtask.
+ *    The servers are picked by a pluggable policy (see ReplicaSelector.h): by default at random
+ *    until reputation is known, or by load, using the requests the client has outstanding at
+ *    each server and the queue length servers report with every response.
  * 3. It collects the responses from these servers and uses majority voting to determine
  *    the correct result for each subtask.
- * 4. The final result is computed as the maximum among the majority results of the subtasks.
+ * 4. The final result is computed by combining the majority results of the subtasks with the
+ *    configured operation (by default the maximum, see ComputeKernels.h).
  * 5. The client assigns scores to servers based on correctness (1 for correct, 0 for incorrect),
- *    then exchanges these scores with other clients via a gossip protocol.
- * 6. In a subsequent round, tasks are reassigned to the top (n/2 + 1) servers based on
- *    the accumulated scores.
+ *    then exchanges these scores with other clients via an epidemic gossip protocol: every
+ *    'gossipInterval' (and after each round) it sends its score vector to 'gossipFanout'
+ *    random peers on the dedicated clientOut[] gates, and peers forward new gossip until
+ *    its hop limit runs out. Duplicates are suppressed with a bounded DigestCache.
+ * 6. Received score vectors are merged into a reputation estimate (see ReputationMerge).
+ *    Once any reputation is known, every further round is by default sent to the top (n/2 + 1)
+ *    servers by that estimate. By default a client runs one job of two rounds (Round 1 random, Round 2 by
+ *    reputation). With 'numJobs' and 'jobInterarrival' it runs an open-loop workload instead:
+ *    jobs arrive independently of completions, several are in flight at once, and the
+ *    reputation learned from earlier jobs steers the later ones.
  * 7. Detailed logs are maintained in a client-specific log file (client_<id>_log.txt)
- *    and a common output file (outputfile.txt).
+ *    and a common output file (outputfile.txt, one per partition under parallel simulation).
+ *
+ * With verification = "witness" (max only), each subtask goes to one server, which returns
+ * the position of the maximum along with it; the client checks that the element there equals
+ * the reported value. A second replica is added as a spot check with a probability that
+ * falls with the server's score, and the larger verified value wins. Responses without a
+ * valid witness are rejected and the subtask is sent to another server.
+ *
+ * With 'subtaskTimeout', a replica that has not answered in time is given up (and cancelled)
+ * and the subtask is sent to another server, up to 'maxRetries' times with a timeout growing
+ * by 'retryBackoff' each time; a subtask whose replicas are all lost is decided on the
+ * responses it has, or left without a result. With 'hedgePercentile', a subtask still short of
+ * responses after that percentile of the recent replica latencies gets one extra replica, and
+ * the first responses to arrive decide it.
+ *
+ * With replication = "adaptive", a subtask is first sent only to as many servers as its
+ * target error rate needs given their estimated honesty (learned from how often each one
+ * agreed with decided results), and to more of them only when the responses disagree or are
+ * not conclusive enough, up to the (n/2 + 1) of fixed replication.
+ *
+ * With 'batchRequests', all subtasks a round assigns to the same server travel in one
+ * SubtaskBatch and come back in one BatchResponse, so a round costs O(n) messages instead
+ * of O(n^2); the batched results go through the same voting path as single responses.
+ *
+ * If the client's out[] gates lead to Aggregators (the network's 'aggregatorFanout'), it sends
+ * each subtask once and receives the aggregator's decision with a vote summary instead of every
+ * replica response (see Aggregator.h); scores and gossip work as before.
+ *
+ * Servers answer with the request object itself. The client recycles the returned requests
+ * (and received gossip) through MessagePools, so once the pools are warm, sending a replica
+ * or a gossip copy allocates no message object.
  */
 class Client : public cSimpleModule {
   private:
-    int currentRound;                             // Indicates current round (1 or 2)
     int totalServers;                             // Total number of server nodes (n)
     int totalClients;                             // Total number of client nodes (m)
-    vector<vector<int>> subtasks;                 // Each element is a subarray (subtask)
-    vector< map<int,int> > responses;             // For each subtask, maps server index (0-indexed) to its result.
-    map<int,int> subtaskResults;                  // Majority result for each subtask.
+    int requestPriority;                          // Priority of this client's requests at priority-queue servers.
+    vector<SubtaskData> subtasks;                 // EQUAL: each element is a shared view of a subarray (subtask)
+    int respondedWords;                           // 64-bit words per subtask in Job::responded.
+
+    // Partitioning of the input array.
+    Partitioning partitioning;                    // 'partitioning' parameter.
+    int numSubtasks;                              // EQUAL / WEIGHTED: subtasks per round.
+    int replicationFactor;                        // Replicas per subtask without witness verification.
+    size_t minChunk;                              // Smallest subtask WEIGHTED and GUIDED cut.
+    double guidedFraction;                        // GUIDED: share of a server's part of the remaining array per chunk.
+    shared_ptr<const void> arrayOwner;            // Keeps the input array alive for the chunks cut from it.
+    const int *arrayElements = nullptr;           // First element of the input array.
+    size_t arraySize = 0;
+    vector<double> serverSpeed;                   // Per server: smoothed elements per second (0 = not measured).
+    double speedSmoothing;                        // Weight of a new service rate sample.
+    double speedSum = 0;                          // Sum of serverSpeed over the measured servers.
+    int measuredServers = 0;
+    vector<double> chunkWeights;                  // WEIGHTED: scratch weights of the round's chunks.
+
+    // Workload: jobs in flight, ordered by id (jobs[0] has id firstJobId).
+    deque<unique_ptr<Job>> jobs;
+    vector<unique_ptr<Job>> freeJobs;             // Recycled Job objects.
+    int firstJobId = 0;                           // Id of jobs.front().
+    int nextJobId = 0;                            // Id of the next arriving job.
+    int numJobs;                                  // Jobs to run (0 = until the simulation ends).
+    int roundsPerJob;                             // Rounds each job runs.
+    cMessage *jobArrivalTimer = nullptr;          // Self-message announcing the next job arrival.
+    long jobsCompleted = 0;
+    simtime_t firstArrival;                       // For the throughput scalar.
+    simtime_t lastCompletion;
+    simsignal_t jobLatencySignal;                 // Emits the arrival-to-completion time of each job.
+    simsignal_t jobsInFlightSignal;               // Emits the number of jobs in flight on every change.
+    simsignal_t subtaskFinalizedSignal;           // Emits the finalization time of each subtask (relative to the round start).
+    bool earlyQuorum;                             // Finalize as soon as the majority is unbeatable and cancel the rest.
+    simsignal_t cancelsSentSignal;                // Emits the number of replicas cancelled for an early-finalized subtask.
+
+    // Request batching: the subtasks bound to one server are sent as a single SubtaskBatch.
+    bool batchRequests;                           // Batch requests per server instead of one message per replica.
+    int batchSize;                                // Entries after which a batch is sent right away (0 = no limit).
+    simtime_t batchTimeout;                       // Time a batch may wait for more entries (0 = sent when the round's requests are dispatched).
+    vector<SubtaskBatch *> pendingBatches;        // Batch being filled for each linkedServers entry (nullptr if none).
+    vector<cMessage *> batchTimers;               // Flush timer of each linkedServers entry (kind = position), if batchTimeout > 0.
+    long batchesSent = 0;                         // For the batching scalars.
+    long batchedRequests = 0;
+
+    // Straggler and crash tolerance: per-subtask timeouts with retries, and hedged requests.
+    simtime_t subtaskTimeout;                     // Time a replica may take before it is given up (0 = wait forever).
+    int maxRetries;                               // Timeouts after which lost replicas are no longer replaced.
+    double retryBackoff;                          // Factor the timeout grows by with every timeout of the subtask.
+    int hedgePercentile;                          // Replica latency percentile after which a subtask is hedged (0 = off).
+    simtime_t hedgeDelay;                         // That percentile, refreshed every round (0 = too few samples yet).
+    vector<double> replicaLatencies;              // Recent replica latencies (ring buffer).
+    size_t latencyCursor = 0;                     // Next slot of replicaLatencies to overwrite.
+    vector<double> latencyScratch;                // Sorted copy of replicaLatencies.
+    simsignal_t timeoutsSignal;                   // Emits the number of replicas given up at a timeout.
+    simsignal_t retriesSentSignal;                // Emits 1 for every replica sent to replace a lost one.
+    simsignal_t hedgesSentSignal;                 // Emits 1 for every hedged request.
+    simsignal_t subtasksFailedSignal;             // Emits 1 for every subtask left without a result.
+
+    // Witness-based verification (max only): one replica per subtask plus score-driven spot checks.
+    bool verifyWitness;                           // 'verification' is "witness".
+    double spotCheckRate;                         // Spot-check probability for a server with score 0...
+    double spotCheckMin;                          // ...decaying with the score down to this floor.
+    long baselineWork;                            // Elements per round under plain majority voting.
+    simsignal_t serverWorkSignal;                 // Emits Job::serverWork at the end of each round.
+    simsignal_t workRatioSignal;                  // Emits serverWork / baselineWork at the end of each round.
+    simsignal_t liesDetectedSignal;               // Emits Job::liesDetected at the end of each round.
+    simsignal_t liesMissedSignal;                 // Emits Job::liesMissed at the end of each round.
+
+    // Adaptive replication: replicas per subtask chosen from the estimated honesty of their servers.
+    bool adaptiveReplication;                     // 'replication' is "adaptive".
+    double targetErrorRate;                       // Accepted probability that a decided subtask is wrong.
+    double priorHonesty;                          // Honesty assumed for a server without a voting record.
+    vector<int> serverDisagreements;              // Per server: responses that differed from the decided result.
+    simsignal_t replicasPerSubtaskSignal;         // Emits the replicas sent for each decided subtask.
+    simsignal_t escalationsSignal;                // Emits the replicas added to a subtask whose responses left it in doubt.
+    simsignal_t wrongResultsSignal;               // Emits Job::wrongResults at the end of each round.
+
+    // Gossip state.
+    cMessage *gossipTimer = nullptr;              // Periodic self-message that originates gossip.
+    simtime_t gossipInterval;                     // Period of gossipTimer (0 = only after each round).
+    int gossipFanout;                             // Random peers each gossip is sent to.
+    int gossipTtl;                                // Hop limit of originated gossip.
+    int64_t gossipSequence = 0;                   // Sequence number of the last originated gossip.
+    bool scoresChanged = false;                   // Scores changed since the last originated gossip.
+    bool reputationKnown = false;                 // Some score or gossip is known, so replicas are chosen by reputation.
+    DigestCache seenGossip;                       // Digests of recently seen gossip (duplicate suppression).
+    vector<int> gossipPeers;                      // Scratch list of gossip gate indices.
+
+    // Reputation merged from the own scores and the peers' gossip.
+    ReputationMerge reputationMerge;              // Merge rule ('reputationMerge' parameter).
+    double reputationDecay;                       // DECAY: weight kept by the history for each new vector.
+    vector<double> gossipReputation;              // Per server: sum of the peers' latest scores (AVERAGE), their maximum (MAX) or decayed average (DECAY).
+    vector<int32_t> peerScores;                   // AVERAGE: latest vector of each peer, totalClients x totalServers.
+    vector<int64_t> peerSequence;                 // AVERAGE: sequence number of that vector (0 = not heard from yet).
+    int knownPeers = 0;                           // AVERAGE: peers heard from.
+    int mergedVectors = 0;                        // Score vectors merged so far.
+    simsignal_t maliciousReplicasSignal;          // Emits Job::maliciousReplicas at the end of each round.
+    ReductionOp *operation = nullptr;             // Operation used to combine the subtask results.
     vector<int> serverScores;                     // 0-indexed score vector for servers.
-    map<int,int> serverIdToIndex;                 // Maps actual Server module ID to 0-indexed server index.
+    vector<simsignal_t> serverScoreSignals;       // Emits serverScores[i] whenever it changes ("serverScore<i>").
+    simsignal_t replicaRttSignal;                 // Emits the round-trip time of every accepted replica response.
+    simsignal_t disagreeingVotesSignal;           // Emits, per decided subtask, the responses that differ from the majority.
+    simsignal_t gossipBytesSignal;                // Emits the payload size of every gossip copy sent.
+    vector<int> linkedServers;                    // Sorted indices of the servers this client is linked to.
+    vector<int> linkGates;                        // out[] gate index of each linkedServers entry.
+    vector<int> aggregatorGates;                  // Aggregator tier: out[] gate index of each linked aggregator (else empty).
+    vector<int> aggregatorOutstanding;            // Subtasks outstanding at each of them.
+    int nextAggregator = 0;                       // Where the search for the least loaded aggregator starts.
+
+    // Replica selection.
+    ReplicaSelector *selector = nullptr;          // Policy chosen by the 'replicaSelection' parameter.
+    ServerLoad serverLoad;                        // Outstanding requests, reported queue lengths and reputation per server.
+    vector<int> chosenServers;                    // Scratch list of the servers chosen for a subtask.
+    vector<int> candidateScratch;                 // Scratch list of the servers a subtask can be resent to.
+
+    // Message recycling (see MessagePool.h).
+    SubtaskRequest *requestTemplate = nullptr;    // Request being sent; each replica gets a pooled copy.
+    MessagePool<SubtaskRequest> requestPool;      // Requests that came back as responses.
+    MessagePool<GossipScores> gossipPool;         // Received gossip, reused for the copies sent.
+    simsignal_t allocationsSignal;                // Emits the heap allocations of every event (needs COUNT_ALLOCS=1).
+    simsignal_t roundMakespanSignal;              // Emits the duration of each round.
+    LogLevel logLevel;                            // Verbosity of the file logs ('logLevel' parameter).
+    FileLogger *logFile = nullptr;                // Buffered handle for client_<id>_log.txt.
+    FileLogger *outputFile = nullptr;             // Shared buffered handle for outputfile.txt.
 
     // Helper Functions:
-    int responsesProcessed();                     // Returns the number of subtasks that received (n/2+1) responses.
-    void broadcastGossip();                       // Broadcasts the server score gossip message to other clients.
-    vector<int> getTopServers();                  // Returns indices of top servers based on serverScores.
-    void logToFile(const string &msg);            // Writes a log message to a client-specific log file.
+    void startJob();                              // Creates the next job and sends its first round.
+    Job *findJob(int jobId);                      // Job in flight with this id, or nullptr.
+    void startRound(Job &job);                    // Resets the job's per-subtask state and sends the round's requests.
+    void startAggregatedRound(Job &job);          // Aggregator tier: sends each subtask once to an aggregator.
+    void handleAggregateResult(const AggregateResult *agg); // Aggregator tier: finalizes a subtask from its vote summary.
+    void completeRound(Job &job);                 // Combines the round's result; starts the next round or completes the job.
+    int jobsInFlight() const;                     // Jobs that have arrived but not completed.
+    bool allJobsDone() const;                     // No more arrivals and no job in flight.
+    void finalizeSubtask(Job &job, int subtaskId, int winner); // Records the winning response and moves the subtask to FINALIZED.
+    void cancelReplicas(Job &job, int subtaskId); // Sends SubtaskCancel to the replicas that have not responded.
+    void handleResult(int jobId, int round, int subtaskId, int senderIndex, int senderId, bool malicious, bool corrupted,
+                      KernelResult &&result, int witness); // Voting path shared by single and batched responses.
+    bool checkWitness(const Job &job, int subtaskId, const KernelResult &result, int witness) const; // Witness points at an element equal to the result.
+    int verifiedWinner(const SubtaskVotes &votes) const; // Position of the largest verified result, or -1.
+    double spotCheckProbability(int serverIndex) const; // Chance that a subtask sent to this server is also spot-checked.
+    double honestyOf(int serverIndex) const;      // Estimated probability that a response of this server is correct.
+    int weighVotes(const SubtaskVotes &votes, double &agree, double &other) const; // Most likely correct response and the likelihoods.
+    void chooseAdaptiveReplicas(vector<int> &chosen, double agree, double other); // Adds servers until the target error rate is met.
+    bool escalateSubtask(Job &job, int subtaskId, double agree, double other); // Sends a subtask in doubt to more servers.
+    bool reassignSubtask(Job &job, int subtaskId); // Sends the subtask to one more linked server; false if none is left.
+    void decideSubtask(Job &job, int subtaskId);  // Finalizes the subtask if its responses suffice.
+    int outstandingReplicas(const Job &job, int subtaskId) const; // Replicas that may still answer or are still to be assigned.
+    void armTimer(Job &job, int subtaskId);       // (Re)schedules the subtask's timer for its next hedge or timeout.
+    void subtaskTimedOut(SubtaskTimer *timer);    // Hedges the subtask, or gives up on its late replicas and retries.
+    simtime_t timeoutFor(int attempt) const { return subtaskTimeout * pow(retryBackoff, attempt); }
+    void refreshHedgeDelay();                     // Recomputes hedgeDelay from the recent replica latencies.
+    void sendCancel(Job &job, int subtaskId, int serverIndex); // Withdraws the request of one replica.
+    void serverAnswered(int serverIndex, int queueLength, double serviceRate); // Updates the queue length and speed estimate from a response.
+    void resetSubtasks(Job &job, int count);      // Sizes and clears the per-subtask arrays for a new round.
+    int addSubtask(Job &job, const SubtaskData &chunk); // GUIDED: appends a newly cut chunk; returns its id.
+    void assignReplica(Job &job, int subtaskId, int serverIndex); // Sends one more replica of a subtask.
+    void pullWork(Job &job, int serverIndex);     // GUIDED: gives an idle server a replica or a new chunk.
+    void cutWeightedChunks(Job &job);             // WEIGHTED: sizes the round's chunks by the speed of their servers.
+    double speedOf(int serverIndex) const;        // Estimated elements per second of a server.
+    bool roundComplete(const Job &job) const;     // The whole array is cut and every subtask is finalized.
+    void dispatchRequest(const SubtaskRequest *msg, int serverIndex); // Sends a copy of the request, or adds it to the server's pending batch.
+    void flushBatch(int link);                    // Sends the pending batch of linkedServers[link], if any.
+    void flushBatches();                          // Sends every pending batch.
+    bool removeFromBatch(const Job &job, int subtaskId, int serverIndex); // Drops a request not sent yet; false if it has left.
+    void broadcastGossip();                       // Originates a gossip message with the current server scores.
+    void sendGossip(GossipScores *gossipMsg);     // Sends copies to 'gossipFanout' random peers and recycles the message.
+    void mergeGossip(const GossipScores *gossip); // Folds a received score vector into gossipReputation.
+    double reputationOf(int serverIndex) const;   // Merged reputation estimate of one server.
+    void buildServerLinks();                      // Fills linkedServers / linkGates (or aggregatorGates) from the out[] gates.
+    int linkOf(int serverIndex) const;            // Position of a linked server in linkedServers.
+    int gateOf(int serverIndex) const;            // out[] gate index leading to a linked server.
+    bool markResponded(Job &job, int subtaskId, int serverIndex); // Sets the response bit; false if it was already set.
+    bool hasResponded(const Job &job, int subtaskId, int serverIndex) const; // The response bit is set.
+    const SubtaskRequest *prepareRequest(const Job &job, int subtaskId); // Fills requestTemplate for job.chunks[subtaskId].
+    void logToFile(const string &msg, LogLevel level = LOG_INFO); // Queues a log message for the client-specific log file.
+    void writeOutput(const string &line);         // Queues a line for the common output file.
+    bool logEnabled(LogLevel level) const { return FILE_LOG_ENABLED && level <= logLevel; }
+    bool traceEnabled(LogLevel level) const { return logEnabled(level) || getEnvir()->isLoggingEnabled(); } // File log or EV shows it.
 
   public:
     int server_mutex = 0;                         // Optional: Mutex for synchronizing responses.
-    set<string> ML;                               // Message log to avoid duplicate gossip forwarding.
     vector<int> res;                              // Additional result storage if needed.
 
-    // send_message: Sends a custom ClientMessage to a specified server.
-    void send_message(vector<int> arr, time_t time, int ID, int arr_len, int server_id) {
-        ClientMessage *newm = new ClientMessage();
-        newm->arr = arr;
-        newm->arr_len = arr_len;
-        newm->time = time;
-        newm->ID = ID;
-        send(newm, "out", server_id);
-    }
-
-    // gossip_message: Sends a custom gossipMessage to a specified server.
-    void gossip_message(string s, int server_id) {
-        gossipMessage *newm = new gossipMessage();
-        newm->s = s;
-        send(newm, "out", server_id);
-    }
+    virtual ~Client();                            // Releases the log file handles, the operation, the policy, the timers and unsent batches.
 
   protected:
-    virtual void initialize() override;         // Called at simulation startup.
+    virtual int numInitStages() const override { return 2; } // Stage 0: topology setup, stage 1: client start.
+    virtual void initialize(int stage) override; // Called at simulation startup.
     virtual void handleMessage(cMessage *msg) override; // Handles incoming messages.
+    virtual void finish() override;             // Records the completed jobs and throughput.
 };
 
 #endif
@@ -0,0 +1,445 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#include "ComputeKernels.h"
+#include <omnetpp.h>
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <map>
+#include <queue>
+#include <sstream>
+using namespace omnetpp;
+using namespace std;
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define KERNELS_X86 1
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#endif
+
+/*
+ * Low-level kernels
+ * -----------------
+ * Every instruction set provides the same table of primitives; the reduction
+ * operations below only call through the table picked once by detectKernels().
+ * All variants return bit-identical results (the histogram bin index is computed
+ * in double precision in every variant for that reason).
+ */
+struct KernelTable {
+    const char *isa;
+    int (*max)(const int *d, size_t n);                        // n > 0
+    int (*min)(const int *d, size_t n);                        // n > 0
+    int64_t (*sum)(const int *d, size_t n);
+    size_t (*firstAbove)(const int *d, size_t n, int threshold); // n if none is above
+    void (*histogram)(const int *d, size_t n, int lo, int hi, int bins, int64_t *counts);
+};
+
+static inline int histogramBin(int x, int lo, int hi, double scale, int bins) {
+    x = std::min(std::max(x, lo), hi - 1);
+    int b = (int)((double)(x - lo) * scale);
+    return b < bins ? b : bins - 1;
+}
+
+// ---- Scalar fallback ----
+
+static int maxScalar(const int *d, size_t n) {
+    return *max_element(d, d + n);
+}
+
+static int minScalar(const int *d, size_t n) {
+    return *min_element(d, d + n);
+}
+
+static int64_t sumScalar(const int *d, size_t n) {
+    int64_t total = 0;
+    for (size_t i = 0; i < n; i++)
+        total += d[i];
+    return total;
+}
+
+static size_t firstAboveScalar(const int *d, size_t n, int threshold) {
+    for (size_t i = 0; i < n; i++)
+        if (d[i] > threshold)
+            return i;
+    return n;
+}
+
+static void histogramScalar(const int *d, size_t n, int lo, int hi, int bins, int64_t *counts) {
+    double scale = (double)bins / ((double)hi - lo);
+    for (size_t i = 0; i < n; i++)
+        counts[histogramBin(d[i], lo, hi, scale, bins)]++;
+}
+
+static const KernelTable scalarKernels = {
+    "scalar", maxScalar, minScalar, sumScalar, firstAboveScalar, histogramScalar
+};
+
+#ifdef KERNELS_X86
+
+// ---- SSE4.1 ----
+
+TARGET_SSE41 static int hmaxSse41(__m128i m) {
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(m);
+}
+
+TARGET_SSE41 static int hminSse41(__m128i m) {
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(m);
+}
+
+TARGET_SSE41 static int maxSse41(const int *d, size_t n) {
+    if (n < 4)
+        return maxScalar(d, n);
+    __m128i acc = _mm_loadu_si128((const __m128i *)d);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4)
+        acc = _mm_max_epi32(acc, _mm_loadu_si128((const __m128i *)(d + i)));
+    int result = hmaxSse41(acc);
+    for (; i < n; i++)
+        result = std::max(result, d[i]);
+    return result;
+}
+
+TARGET_SSE41 static int minSse41(const int *d, size_t n) {
+    if (n < 4)
+        return minScalar(d, n);
+    __m128i acc = _mm_loadu_si128((const __m128i *)d);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4)
+        acc = _mm_min_epi32(acc, _mm_loadu_si128((const __m128i *)(d + i)));
+    int result = hminSse41(acc);
+    for (; i < n; i++)
+        result = std::min(result, d[i]);
+    return result;
+}
+
+TARGET_SSE41 static int64_t sumSse41(const int *d, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(d + i));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(v));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(_mm_unpackhi_epi64(v, v)));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    int64_t total = lanes[0] + lanes[1];
+    for (; i < n; i++)
+        total += d[i];
+    return total;
+}
+
+TARGET_SSE41 static size_t firstAboveSse41(const int *d, size_t n, int threshold) {
+    __m128i t = _mm_set1_epi32(threshold);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i gt = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(d + i)), t);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(gt));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    for (; i < n; i++)
+        if (d[i] > threshold)
+            return i;
+    return n;
+}
+
+TARGET_SSE41 static void histogramSse41(const int *d, size_t n, int lo, int hi, int bins, int64_t *counts) {
+    double scale = (double)bins / ((double)hi - lo);
+    __m128i vlo = _mm_set1_epi32(lo), vtop = _mm_set1_epi32(hi - 1);
+    __m128d vscale = _mm_set1_pd(scale);
+    int idx[4];
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(d + i));
+        v = _mm_sub_epi32(_mm_min_epi32(_mm_max_epi32(v, vlo), vtop), vlo);
+        __m128i a = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(v), vscale));
+        __m128i b = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(v, v)), vscale));
+        _mm_storeu_si128((__m128i *)idx, _mm_unpacklo_epi64(a, b));
+        for (int k = 0; k < 4; k++)
+            counts[idx[k] < bins ? idx[k] : bins - 1]++;
+    }
+    for (; i < n; i++)
+        counts[histogramBin(d[i], lo, hi, scale, bins)]++;
+}
+
+static const KernelTable sse41Kernels = {
+    "sse4.1", maxSse41, minSse41, sumSse41, firstAboveSse41, histogramSse41
+};
+
+// ---- AVX2 ----
+
+TARGET_AVX2 static int maxAvx2(const int *d, size_t n) {
+    if (n < 8)
+        return maxScalar(d, n);
+    __m256i acc = _mm256_loadu_si256((const __m256i *)d);
+    size_t i = 8;
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_max_epi32(acc, _mm256_loadu_si256((const __m256i *)(d + i)));
+    int result = hmaxSse41(_mm_max_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1)));
+    for (; i < n; i++)
+        result = std::max(result, d[i]);
+    return result;
+}
+
+TARGET_AVX2 static int minAvx2(const int *d, size_t n) {
+    if (n < 8)
+        return minScalar(d, n);
+    __m256i acc = _mm256_loadu_si256((const __m256i *)d);
+    size_t i = 8;
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_min_epi32(acc, _mm256_loadu_si256((const __m256i *)(d + i)));
+    int result = hminSse41(_mm_min_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1)));
+    for (; i < n; i++)
+        result = std::min(result, d[i]);
+    return result;
+}
+
+TARGET_AVX2 static int64_t sumAvx2(const int *d, size_t n) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(d + i))));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(d + i + 4))));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(acc0, acc1));
+    int64_t total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; i++)
+        total += d[i];
+    return total;
+}
+
+TARGET_AVX2 static size_t firstAboveAvx2(const int *d, size_t n, int threshold) {
+    __m256i t = _mm256_set1_epi32(threshold);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i gt = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)(d + i)), t);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(gt));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    for (; i < n; i++)
+        if (d[i] > threshold)
+            return i;
+    return n;
+}
+
+TARGET_AVX2 static void histogramAvx2(const int *d, size_t n, int lo, int hi, int bins, int64_t *counts) {
+    double scale = (double)bins / ((double)hi - lo);
+    __m256i vlo = _mm256_set1_epi32(lo), vtop = _mm256_set1_epi32(hi - 1);
+    __m256d vscale = _mm256_set1_pd(scale);
+    int idx[8];
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(d + i));
+        v = _mm256_sub_epi32(_mm256_min_epi32(_mm256_max_epi32(v, vlo), vtop), vlo);
+        __m128i a = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), vscale));
+        __m128i b = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), vscale));
+        _mm_storeu_si128((__m128i *)idx, a);
+        _mm_storeu_si128((__m128i *)(idx + 4), b);
+        for (int k = 0; k < 8; k++)
+            counts[idx[k] < bins ? idx[k] : bins - 1]++;
+    }
+    for (; i < n; i++)
+        counts[histogramBin(d[i], lo, hi, scale, bins)]++;
+}
+
+static const KernelTable avx2Kernels = {
+    "avx2", maxAvx2, minAvx2, sumAvx2, firstAboveAvx2, histogramAvx2
+};
+
+#endif // KERNELS_X86
+
+// Picks the widest instruction set supported by the CPU we are running on.
+static const KernelTable &detectKernels() {
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return avx2Kernels;
+    if (__builtin_cpu_supports("sse4.1"))
+        return sse41Kernels;
+#endif
+    return scalarKernels;
+}
+
+static const KernelTable &kernels() {
+    static const KernelTable &table = detectKernels();
+    return table;
+}
+
+const char *kernelIsaName() {
+    return kernels().isa;
+}
+
+/*
+ * Reduction operations
+ * --------------------
+ */
+
+// Largest element; subtask results combine with max.
+class MaxOp : public ReductionOp {
+  public:
+    const char *getName() const override { return "max"; }
+    KernelResult reduce(const int *data, size_t n) const override {
+        return KernelResult(1, n > 0 ? kernels().max(data, n) : INT_MIN);
+    }
+    void combine(KernelResult &acc, const KernelResult &partial) const override {
+        if (acc.empty())
+            acc = partial;
+        else
+            acc[0] = std::max(acc[0], partial[0]);
+    }
+};
+
+// Smallest element; subtask results combine with min.
+class MinOp : public ReductionOp {
+  public:
+    const char *getName() const override { return "min"; }
+    KernelResult reduce(const int *data, size_t n) const override {
+        return KernelResult(1, n > 0 ? kernels().min(data, n) : INT_MAX);
+    }
+    void combine(KernelResult &acc, const KernelResult &partial) const override {
+        if (acc.empty())
+            acc = partial;
+        else
+            acc[0] = std::min(acc[0], partial[0]);
+    }
+};
+
+// Sum of all elements (64-bit accumulation); subtask results add up.
+class SumOp : public ReductionOp {
+  public:
+    const char *getName() const override { return "sum"; }
+    KernelResult reduce(const int *data, size_t n) const override {
+        return KernelResult(1, kernels().sum(data, n));
+    }
+    void combine(KernelResult &acc, const KernelResult &partial) const override {
+        if (acc.empty())
+            acc = partial;
+        else
+            acc[0] += partial[0];
+    }
+};
+
+/*
+ * Sort-and-select: the k largest elements in descending order. A size-k min-heap
+ * holds the current candidates; the SIMD firstAbove() kernel skips whole vectors
+ * that cannot enter the heap, so most of the array is only compared, never pushed.
+ */
+class SelectOp : public ReductionOp {
+  public:
+    SelectOp(int k) : k(k) {}
+    const char *getName() const override { return "select"; }
+    KernelResult reduce(const int *data, size_t n) const override {
+        priority_queue<int, vector<int>, greater<int>> heap;
+        size_t i = 0;
+        for (; i < n && (int)heap.size() < k; i++)
+            heap.push(data[i]);
+        while (i < n) {
+            i += kernels().firstAbove(data + i, n - i, heap.top());
+            if (i >= n)
+                break;
+            heap.pop();
+            heap.push(data[i++]);
+        }
+        KernelResult result(heap.size());
+        for (int j = (int)heap.size() - 1; j >= 0; j--) {
+            result[j] = heap.top();
+            heap.pop();
+        }
+        return result;
+    }
+    void combine(KernelResult &acc, const KernelResult &partial) const override {
+        KernelResult merged(acc.size() + partial.size());
+        std::merge(acc.begin(), acc.end(), partial.begin(), partial.end(), merged.begin(), greater<int64_t>());
+        if ((int)merged.size() > k)
+            merged.resize(k);
+        acc.swap(merged);
+    }
+
+  private:
+    int k;
+};
+
+// Equal-width histogram over [lo, hi); subtask histograms add up bin by bin.
+class HistogramOp : public ReductionOp {
+  public:
+    HistogramOp(int bins, int lo, int hi) : bins(bins), lo(lo), hi(hi) {}
+    const char *getName() const override { return "histogram"; }
+    KernelResult reduce(const int *data, size_t n) const override {
+        KernelResult counts(bins, 0);
+        kernels().histogram(data, n, lo, hi, bins, counts.data());
+        return counts;
+    }
+    void combine(KernelResult &acc, const KernelResult &partial) const override {
+        if (acc.empty()) {
+            acc = partial;
+            return;
+        }
+        for (size_t i = 0; i < acc.size() && i < partial.size(); i++)
+            acc[i] += partial[i];
+    }
+
+  private:
+    int bins, lo, hi;
+};
+
+static ReductionOp *createMax(const KernelParams &) { return new MaxOp(); }
+static ReductionOp *createMin(const KernelParams &) { return new MinOp(); }
+static ReductionOp *createSum(const KernelParams &) { return new SumOp(); }
+
+static ReductionOp *createSelect(const KernelParams &params) {
+    if (params.selectK < 1)
+        throw cRuntimeError("selectK must be at least 1 (got %d)", params.selectK);
+    return new SelectOp(params.selectK);
+}
+
+static ReductionOp *createHistogram(const KernelParams &params) {
+    if (params.histogramBins < 1)
+        throw cRuntimeError("histogramBins must be at least 1 (got %d)", params.histogramBins);
+    if ((int64_t)params.histogramMax - params.histogramMin < 1 ||
+        (int64_t)params.histogramMax - params.histogramMin > INT_MAX)
+        throw cRuntimeError("Invalid histogram range [%d, %d)", params.histogramMin, params.histogramMax);
+    return new HistogramOp(params.histogramBins, params.histogramMin, params.histogramMax);
+}
+
+static map<string, ReductionFactory> &registry() {
+    static map<string, ReductionFactory> factories = {
+        {"max", createMax},
+        {"min", createMin},
+        {"sum", createSum},
+        {"select", createSelect},
+        {"histogram", createHistogram},
+    };
+    return factories;
+}
+
+void registerReductionOp(const string &name, ReductionFactory factory) {
+    registry()[name] = factory;
+}
+
+ReductionOp *createReductionOp(const string &name, const KernelParams &params) {
+    auto it = registry().find(name);
+    if (it == registry().end())
+        throw cRuntimeError("Unknown operation '%s'", name.c_str());
+    return it->second(params);
+}
+
+string resultToString(const KernelResult &result) {
+    if (result.size() == 1)
+        return to_string(result[0]);
+    stringstream ss;
+    ss << "[";
+    for (size_t i = 0; i < result.size(); i++)
+        ss << (i ? ", " : "") << result[i];
+    ss << "]";
+    return ss.str();
+}
@@ -0,0 +1,87 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _COMPUTEKERNELS_H
+#define _COMPUTEKERNELS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+using namespace std;
+
+/**
+ * @brief Result of a reduction over one subtask (or over the whole job).
+ *
+ * Scalar operations (max, min, sum) produce one value, "select" produces the
+ * k largest values in descending order and "histogram" one count per bin.
+ */
+typedef vector<int64_t> KernelResult;
+
+/**
+ * @brief Arguments of the parameterized operations, read from the
+ *        selectK / histogramBins / histogramMin / histogramMax NED parameters.
+ */
+struct KernelParams {
+    int selectK = 3;              // Number of largest elements kept by "select".
+    int histogramBins = 10;       // Number of equal-width bins of "histogram".
+    int histogramMin = 0;         // Lower bound of the first bin (smaller values are clamped).
+    int histogramMax = 100;       // Upper bound of the last bin (larger values are clamped).
+};
+
+/**
+ * @brief A reduction operation a server can execute on a subtask.
+ *
+ * reduce() computes the partial result of one subarray on the server; the
+ * client folds the majority results of all subtasks into the final result
+ * with combine(). Both use the SIMD kernels selected at startup.
+ */
+class ReductionOp {
+  public:
+    virtual ~ReductionOp() {}
+
+    /**
+     * @brief Name under which the operation is registered.
+     */
+    virtual const char *getName() const = 0;
+
+    /**
+     * @brief Computes the result of the operation over data[0..n).
+     */
+    virtual KernelResult reduce(const int *data, size_t n) const = 0;
+
+    /**
+     * @brief Merges a subtask result into the accumulated result.
+     *        An empty accumulator acts as the identity.
+     */
+    virtual void combine(KernelResult &acc, const KernelResult &partial) const = 0;
+};
+
+typedef ReductionOp *(*ReductionFactory)(const KernelParams &params);
+
+/**
+ * @brief Adds an operation to the registry. The built-in operations (max, min,
+ *        sum, select, histogram) are registered automatically.
+ */
+void registerReductionOp(const string &name, ReductionFactory factory);
+
+/**
+ * @brief Creates the registered operation 'name'; the caller owns it.
+ *        Throws cRuntimeError if no such operation exists.
+ */
+ReductionOp *createReductionOp(const string &name, const KernelParams &params);
+
+/**
+ * @brief Instruction set of the kernels chosen by runtime CPU detection:
+ *        "avx2", "sse4.1" or "scalar".
+ */
+const char *kernelIsaName();
+
+/**
+ * @brief Formats a result for the logs: a single value as-is, otherwise "[a, b, ...]".
+ */
+string resultToString(const KernelResult &result);
+
+#endif // _COMPUTEKERNELS_H
@@ -0,0 +1,67 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _DIGESTCACHE_H
+#define _DIGESTCACHE_H
+
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+/**
+ * @brief Bounded set of recently seen message digests, used to suppress
+ *        duplicate gossip forwarding.
+ *
+ * A direct-mapped table of 64-bit digests: each digest has exactly one slot,
+ * and a newer digest simply overwrites an older one. Memory is fixed no matter
+ * how many messages flow through, at the cost of occasionally forgetting an old
+ * digest (the message is then forwarded once more; the hop limit of the gossip
+ * bounds the damage). There are no false positives: a fresh message is never
+ * mistaken for a duplicate.
+ */
+class DigestCache {
+  public:
+    /**
+     * @brief Sets the table size (rounded up to a power of two) and forgets all digests.
+     */
+    void resize(size_t slots) {
+        size_t size = 1;
+        while (size < slots)
+            size <<= 1;
+        table.assign(size, 0);
+        mask = size - 1;
+    }
+
+    /**
+     * @brief Records a digest.
+     * @return true if the digest was already present (i.e. the message is a duplicate).
+     */
+    bool checkAndInsert(uint64_t digest) {
+        uint64_t &slot = table[digest & mask];
+        if (slot == digest)
+            return true;
+        slot = digest;
+        return false;
+    }
+
+    /**
+     * @brief Digest of a gossip message, from its originator and sequence number (never 0,
+     *        which marks an empty slot).
+     */
+    static uint64_t digestOf(int originId, int64_t sequence) {
+        // splitmix64 finalizer to spread consecutive sequence numbers over the table.
+        uint64_t z = ((uint64_t)(uint32_t)originId << 40) ^ (uint64_t)sequence;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z ^= z >> 31;
+        return z ? z : 1;
+    }
+
+  private:
+    vector<uint64_t> table;
+    uint64_t mask = 0;
+};
+
+#endif // _DIGESTCACHE_H
@@ -0,0 +1,163 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#include "Logger.h"
+#include <omnetpp.h>
+#include <chrono>
+#include <cstring>
+using namespace omnetpp;
+using namespace std;
+
+mutex FileLogger::lock;
+condition_variable FileLogger::wakeWriter;
+condition_variable FileLogger::drained;
+map<string, FileLogger *> FileLogger::loggers;
+thread FileLogger::writer;
+bool FileLogger::stopWriter = false;
+bool FileLogger::wakeRequested = false;
+unsigned long FileLogger::passesStarted = 0;
+unsigned long FileLogger::passesDone = 0;
+
+// Stops the writer thread at program exit in case some module never released its logger
+// (a joinable std::thread must not be destroyed).
+struct WriterShutdown {
+    ~WriterShutdown() {
+        unique_lock<mutex> guard(FileLogger::lock);
+        FileLogger::stopWriterLocked(guard);
+        for (auto &entry : FileLogger::loggers)
+            delete entry.second;
+        FileLogger::loggers.clear();
+    }
+};
+static WriterShutdown writerShutdown;
+
+LogLevel parseLogLevel(const char *name) {
+    if (strcmp(name, "off") == 0)
+        return LOG_OFF;
+    if (strcmp(name, "error") == 0)
+        return LOG_ERROR;
+    if (strcmp(name, "info") == 0)
+        return LOG_INFO;
+    if (strcmp(name, "debug") == 0)
+        return LOG_DEBUG;
+    throw cRuntimeError("Unknown logLevel '%s' (expected off, error, info or debug)", name);
+}
+
+FileLogger::FileLogger(const string &fileName) : fileName(fileName), ring(RING_CAPACITY) {
+    file = fopen(fileName.c_str(), "a");
+}
+
+FileLogger::~FileLogger() {
+    if (file)
+        fclose(file);
+}
+
+FileLogger *FileLogger::acquire(const string &fileName) {
+    unique_lock<mutex> guard(lock);
+    FileLogger *&logger = loggers[fileName];
+    if (!logger)
+        logger = new FileLogger(fileName);
+    logger->refCount++;
+    if (!writer.joinable()) {
+        stopWriter = false;
+        writer = thread(writerLoop);
+    }
+    return logger;
+}
+
+void FileLogger::release(FileLogger *logger) {
+    if (!logger)
+        return;
+    {
+        lock_guard<mutex> guard(lock);
+        if (--logger->refCount > 0)
+            return;
+    }
+    // Last user: make sure everything queued so far is on disk before closing the file.
+    flushAll();
+    unique_lock<mutex> guard(lock);
+    if (logger->refCount > 0)
+        return;   // Re-acquired while flushing.
+    loggers.erase(logger->fileName);
+    delete logger;
+    if (loggers.empty())
+        stopWriterLocked(guard);
+}
+
+void FileLogger::flushAll() {
+    unique_lock<mutex> guard(lock);
+    if (!writer.joinable())
+        return;
+    // Wait for a pass that starts after this call, so it sees every line queued so far.
+    unsigned long target = passesStarted + 1;
+    wakeRequested = true;
+    wakeWriter.notify_one();
+    drained.wait(guard, [target] { return passesDone >= target; });
+}
+
+void FileLogger::write(const string &line) {
+    unique_lock<mutex> guard(lock);
+    // Buffer full: hand the batch to the writer and wait for room.
+    while (count == RING_CAPACITY) {
+        wakeRequested = true;
+        wakeWriter.notify_one();
+        drained.wait(guard);
+    }
+    ring[(head + count) % RING_CAPACITY] = line;
+    count++;
+    if (count == HIGH_WATER) {
+        wakeRequested = true;
+        wakeWriter.notify_one();
+    }
+}
+
+size_t FileLogger::drainLocked(string &batch) {
+    size_t drainedLines = count;
+    for (; count > 0; count--) {
+        batch += ring[head];
+        batch += '\n';
+        head = (head + 1) % RING_CAPACITY;
+    }
+    return drainedLines;
+}
+
+void FileLogger::writerLoop() {
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        wakeWriter.wait_for(guard, chrono::milliseconds(FLUSH_INTERVAL_MS),
+                            [] { return wakeRequested || stopWriter; });
+        wakeRequested = false;
+        unsigned long pass = ++passesStarted;
+        bool stopping = stopWriter;
+
+        // Collect one batch per file under the lock, then write them without holding it.
+        vector<pair<FILE *, string>> batches;
+        for (auto &entry : loggers) {
+            string batch;
+            if (entry.second->drainLocked(batch) > 0 && entry.second->file)
+                batches.push_back(make_pair(entry.second->file, move(batch)));
+        }
+        guard.unlock();
+        for (auto &b : batches) {
+            fwrite(b.second.data(), 1, b.second.size(), b.first);
+            fflush(b.first);
+        }
+        guard.lock();
+        passesDone = pass;
+        drained.notify_all();
+        if (stopping)
+            break;
+    }
+}
+
+void FileLogger::stopWriterLocked(unique_lock<mutex> &guard) {
+    if (!writer.joinable())
+        return;
+    stopWriter = true;
+    wakeWriter.notify_one();
+    guard.unlock();
+    writer.join();
+    guard.lock();
+}
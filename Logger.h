@@ -0,0 +1,118 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _LOGGER_H
+#define _LOGGER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdio>
+using namespace std;
+
+/*
+ * Building with -DNO_FILE_LOG (e.g. "make MODE=release NO_FILE_LOG=1", see makefrag)
+ * compiles file logging out entirely: isEnabled() becomes a constant false, so the
+ * message formatting guarded by it is removed by the optimizer and no writer thread
+ * is ever started. Intended for Cmdenv performance runs.
+ */
+#ifdef NO_FILE_LOG
+#define FILE_LOG_ENABLED 0
+#else
+#define FILE_LOG_ENABLED 1
+#endif
+
+/**
+ * @brief Verbosity levels for file logging, selected per module via the
+ *        'logLevel' NED parameter ("off", "error", "info", "debug").
+ */
+enum LogLevel {
+    LOG_OFF = 0,
+    LOG_ERROR,
+    LOG_INFO,
+    LOG_DEBUG
+};
+
+/**
+ * @brief Converts a 'logLevel' parameter value into a LogLevel.
+ *        Throws cRuntimeError for unknown names.
+ */
+LogLevel parseLogLevel(const char *name);
+
+/**
+ * @brief Buffered, asynchronous log file handle.
+ *
+ * One FileLogger exists per file name and is shared by every module that
+ * acquires it (each module gets its own file; outputfile.txt is shared by all
+ * clients). The file is opened once in append mode and stays open until the
+ * last user releases it.
+ *
+ * write() only appends the line to a fixed-size in-memory ring buffer. A single
+ * background writer thread drains all ring buffers in batches, either when a
+ * buffer passes its high-water mark or periodically, so the simulation thread
+ * never blocks on file I/O unless a buffer is completely full.
+ */
+class FileLogger {
+  public:
+    /**
+     * @brief Returns the shared logger for the given file, opening it on first use.
+     * @param fileName The log file, opened in append mode.
+     */
+    static FileLogger *acquire(const string &fileName);
+
+    /**
+     * @brief Drops one reference; the last release flushes and closes the file.
+     */
+    static void release(FileLogger *logger);
+
+    /**
+     * @brief Blocks until every buffered line of every logger has been written.
+     */
+    static void flushAll();
+
+    /**
+     * @brief Queues one line (a newline is appended) for the writer thread.
+     */
+    void write(const string &line);
+
+  private:
+    static const size_t RING_CAPACITY = 1024;   // Lines buffered per file.
+    static const size_t HIGH_WATER = 512;       // Fill level that wakes the writer early.
+    static const int FLUSH_INTERVAL_MS = 200;   // Periodic flush interval of the writer.
+
+    string fileName;
+    FILE *file = nullptr;
+    int refCount = 0;
+
+    // Ring buffer; guarded by the global mutex.
+    vector<string> ring;
+    size_t head = 0;                            // Index of the oldest queued line.
+    size_t count = 0;                           // Number of queued lines.
+
+    FileLogger(const string &fileName);
+    ~FileLogger();
+    size_t drainLocked(string &batch);          // Moves queued lines into 'batch'.
+
+    // Shared writer state.
+    static mutex lock;
+    static condition_variable wakeWriter;       // Signalled when a buffer needs draining.
+    static condition_variable drained;          // Signalled after every writer pass.
+    static map<string, FileLogger *> loggers;
+    static thread writer;
+    static bool stopWriter;
+    static bool wakeRequested;                  // Set by producers/flushAll() to start a pass now.
+    static unsigned long passesStarted;         // Writer passes begun so far.
+    static unsigned long passesDone;            // Writer passes completed so far.
+
+    static void writerLoop();
+    static void stopWriterLocked(unique_lock<mutex> &guard);
+
+    friend struct WriterShutdown;
+};
+
+#endif // _LOGGER_H
@@ -0,0 +1,95 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#include "MappedArray.h"
+#include <omnetpp.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace omnetpp;
+using namespace std;
+
+static_assert(sizeof(int) == 4, "MappedArray expects 32-bit int elements");
+
+#ifdef _WIN32
+
+shared_ptr<const MappedArray> MappedArray::open(const string &fileName) {
+    shared_ptr<MappedArray> array(new MappedArray());
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw cRuntimeError("Cannot open array file '%s'", fileName.c_str());
+    array->fileHandle = file;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+        throw cRuntimeError("Cannot get the size of array file '%s'", fileName.c_str());
+    array->mappedBytes = (size_t)fileSize.QuadPart;
+    if (array->mappedBytes % sizeof(int) != 0)
+        throw cRuntimeError("Array file '%s' is not a whole number of 32-bit integers", fileName.c_str());
+    array->length = array->mappedBytes / sizeof(int);
+    if (array->length == 0)
+        return array;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+        throw cRuntimeError("Cannot map array file '%s'", fileName.c_str());
+    array->mappingHandle = mapping;
+    array->elements = (const int *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!array->elements)
+        throw cRuntimeError("Cannot map array file '%s'", fileName.c_str());
+    return array;
+}
+
+MappedArray::~MappedArray() {
+    if (elements)
+        UnmapViewOfFile(elements);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+    if (fileHandle)
+        CloseHandle(fileHandle);
+}
+
+#else
+
+shared_ptr<const MappedArray> MappedArray::open(const string &fileName) {
+    shared_ptr<MappedArray> array(new MappedArray());
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw cRuntimeError("Cannot open array file '%s'", fileName.c_str());
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw cRuntimeError("Cannot get the size of array file '%s'", fileName.c_str());
+    }
+    array->mappedBytes = (size_t)info.st_size;
+    if (array->mappedBytes % sizeof(int) != 0) {
+        close(fd);
+        throw cRuntimeError("Array file '%s' is not a whole number of 32-bit integers", fileName.c_str());
+    }
+    array->length = array->mappedBytes / sizeof(int);
+    if (array->length > 0) {
+        void *address = mmap(nullptr, array->mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            close(fd);
+            throw cRuntimeError("Cannot map array file '%s'", fileName.c_str());
+        }
+        // Each subtask is scanned front to back once per replica.
+        madvise(address, array->mappedBytes, MADV_SEQUENTIAL);
+        array->elements = (const int *)address;
+    }
+    close(fd);   // The mapping stays valid without the descriptor.
+    return array;
+}
+
+MappedArray::~MappedArray() {
+    if (elements)
+        munmap((void *)elements, mappedBytes);
+}
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _MAPPEDARRAY_H
+#define _MAPPEDARRAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+using namespace std;
+
+/**
+ * @brief Read-only memory mapping of a binary input array.
+ *
+ * The file is a raw sequence of 32-bit little-endian integers with no header
+ * (e.g. written by numpy's astype('<i4').tofile()), so the element count is
+ * the file size / 4. Mapping costs the same for any file size: pages are only
+ * read from disk when a server first touches its subtask, and the OS shares
+ * them between all clients mapping the same file.
+ *
+ * Subtasks are views into the mapping (see SubtaskData). Each view holds a
+ * shared_ptr to the MappedArray, so the file stays mapped as long as any
+ * request still refers to it.
+ */
+class MappedArray {
+  public:
+    /**
+     * @brief Maps 'fileName'. Throws cRuntimeError if the file cannot be opened
+     *        or mapped, or if its size is not a multiple of 4 bytes.
+     */
+    static shared_ptr<const MappedArray> open(const string &fileName);
+
+    ~MappedArray();
+
+    const int *data() const { return elements; }
+    size_t size() const { return length; }
+
+  private:
+    MappedArray() {}
+    MappedArray(const MappedArray &) = delete;
+    MappedArray &operator=(const MappedArray &) = delete;
+
+    const int *elements = nullptr;  // Start of the mapping.
+    size_t length = 0;              // Number of elements.
+    size_t mappedBytes = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+};
+
+#endif // _MAPPEDARRAY_H
@@ -0,0 +1,82 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _MESSAGEPOOL_H
+#define _MESSAGEPOOL_H
+
+#include <omnetpp.h>
+#include <vector>
+using namespace omnetpp;
+using namespace std;
+
+/**
+ * @brief Free list of message objects of one type, owned by a single module.
+ *
+ * Instead of deleting a message it is done with, the module releases it to the
+ * pool, and the next message of that type is taken from the pool instead of
+ * allocated. A recycled message is overwritten with cMessage's assignment
+ * operator, which copies the name and all fields but keeps the object's own
+ * message id. Messages only enter the pool after they have arrived at the
+ * module, so it always owns them; at most 'capacity' are kept, the rest are
+ * deleted as usual.
+ *
+ * Dynamic array fields still allocate when they are resized or copied, so
+ * pooled messages should keep such fields empty where possible.
+ */
+template <class T>
+class MessagePool {
+  public:
+    explicit MessagePool(size_t capacity = 256) : capacity(capacity) { pool.reserve(capacity); }
+
+    ~MessagePool() {
+        for (T *msg : pool)
+            delete msg;
+    }
+
+    /**
+     * @brief A message named 'name'. A recycled one still holds the fields it was released with.
+     */
+    T *acquire(const char *name) {
+        if (pool.empty())
+            return new T(name);
+        T *msg = pool.back();
+        pool.pop_back();
+        msg->setName(name);
+        return msg;
+    }
+
+    /**
+     * @brief A copy of 'prototype', like prototype.dup().
+     */
+    T *copyOf(const T &prototype) {
+        if (pool.empty())
+            return prototype.dup();
+        T *msg = pool.back();
+        pool.pop_back();
+        *msg = prototype;
+        return msg;
+    }
+
+    /**
+     * @brief Returns a message the module owns (received, or acquired and not sent) to the pool.
+     */
+    void release(T *msg) {
+        if (pool.size() < capacity)
+            pool.push_back(msg);
+        else
+            delete msg;
+    }
+
+    size_t size() const { return pool.size(); }
+
+  private:
+    MessagePool(const MessagePool &) = delete;
+    MessagePool &operator=(const MessagePool &) = delete;
+
+    vector<T *> pool;
+    size_t capacity;
+};
+
+#endif // _MESSAGEPOOL_H
@@ -0,0 +1,28 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#include "PercentileRecorder.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+using namespace omnetpp;
+using namespace std;
+
+Register_ResultRecorder("percentiles", PercentileRecorder);
+
+void PercentileRecorder::collect(simtime_t_cref t, double value, cObject *details) {
+    values.push_back(value);
+}
+
+void PercentileRecorder::finish(cResultFilter *prev) {
+    if (values.empty())
+        return;
+    sort(values.begin(), values.end());
+    for (int p : {50, 90, 95, 99}) {
+        size_t rank = (size_t)ceil(p / 100.0 * values.size());
+        string name = string(getStatisticName()) + ":p" + to_string(p);
+        getComponent()->recordScalar(name.c_str(), values[max(rank, (size_t)1) - 1]);
+    }
+}
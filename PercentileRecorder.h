@@ -0,0 +1,34 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _PERCENTILERECORDER_H
+#define _PERCENTILERECORDER_H
+
+#include <omnetpp.h>
+#include <vector>
+using namespace omnetpp;
+using namespace std;
+
+/**
+ * @brief Result recorder that writes the p50, p90, p95 and p99 of a statistic as scalars.
+ *
+ * Used as record=percentiles in a @statistic, next to the built-in recorders
+ * (vector, histogram, mean, ...). All values are kept until the end of the
+ * simulation, where they are sorted once and the nearest-rank percentiles are
+ * recorded as "<statistic>:p50" and so on in the .sca file, so that tail
+ * latencies can be read directly instead of being estimated from histogram bins.
+ */
+class PercentileRecorder : public cNumericResultRecorder {
+  protected:
+    virtual void collect(simtime_t_cref t, double value, cObject *details) override;
+
+  public:
+    virtual void finish(cResultFilter *prev) override;
+
+  private:
+    vector<double> values;
+};
+
+#endif // _PERCENTILERECORDER_H
@@ -0,0 +1,240 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#include "ReplicaSelector.h"
+#include <algorithm>
+#include <map>
+#include <sstream>
+using namespace omnetpp;
+using namespace std;
+
+/*
+ * Candidates not chosen yet, i.e. load.servers minus 'chosen'. Subtasks get a
+ * handful of replicas, so the linear membership test is cheaper than a set.
+ */
+static void remainingCandidates(const ServerLoad &load, const vector<int> &chosen, vector<int> &pool) {
+    pool.clear();
+    for (int serverIndex : load.servers)
+        if (find(chosen.begin(), chosen.end(), serverIndex) == chosen.end())
+            pool.push_back(serverIndex);
+}
+
+// Appends 'count' servers drawn uniformly without replacement from 'pool' (partial Fisher-Yates).
+static void sampleUniform(vector<int> &pool, int count, cRNG *rng, vector<int> &chosen) {
+    int n = pool.size();
+    count = min(count, n);
+    for (int i = 0; i < count; i++) {
+        int j = intuniform(rng, i, n - 1);
+        swap(pool[i], pool[j]);
+        chosen.push_back(pool[i]);
+    }
+}
+
+/*
+ * Uniform
+ * -------
+ * Every linked server is equally likely, independent of load and reputation.
+ */
+class UniformSelector : public ReplicaSelector {
+  public:
+    virtual const char *getName() const override { return "uniform"; }
+
+    virtual void select(const ServerLoad &load, int count, cRNG *rng, vector<int> &chosen) override {
+        remainingCandidates(load, chosen, pool);
+        sampleUniform(pool, count, rng, chosen);
+    }
+
+  private:
+    vector<int> pool;
+};
+
+/*
+ * Top
+ * ---
+ * The top (n/2 + 1) linked servers by reputation, ties going to the larger server
+ * index, filled up at random if a subtask needs more replicas; uniform while no
+ * reputation is known. Successive subtasks start at successive ranks, so a
+ * subtask with fewer replicas than top servers does not always land on the best one.
+ */
+class TopSelector : public ReplicaSelector {
+  public:
+    virtual const char *getName() const override { return "top"; }
+
+    virtual void beginRound(const ServerLoad &load) override {
+        top.clear();
+        next = 0;
+        if (!load.reputationKnown)
+            return;
+        const vector<double> &estimate = load.reputation;
+        auto better = [&estimate](int a, int b) {
+            return estimate[a] != estimate[b] ? estimate[a] > estimate[b] : a > b;
+        };
+        // Only the top ones are needed: nth_element partitions them out, then just those are sorted.
+        int num = min((int)load.outstanding.size() / 2 + 1, (int)load.servers.size());
+        top = load.servers;
+        nth_element(top.begin(), top.begin() + (num - 1), top.end(), better);
+        top.resize(num);
+        sort(top.begin(), top.end(), better);
+    }
+
+    virtual void select(const ServerLoad &load, int count, cRNG *rng, vector<int> &chosen) override {
+        if (!top.empty()) {
+            int fromTop = 0;
+            for (size_t k = 0; k < top.size() && fromTop < count; k++) {
+                int serverIndex = top[(next + k) % top.size()];
+                if (find(chosen.begin(), chosen.end(), serverIndex) == chosen.end()) {
+                    chosen.push_back(serverIndex);
+                    fromTop++;
+                }
+            }
+            next = (next + 1) % top.size();
+            count -= fromTop;
+        }
+        if (count > 0) {
+            remainingCandidates(load, chosen, pool);
+            sampleUniform(pool, count, rng, chosen);
+        }
+    }
+
+    virtual string roundSummary(const ServerLoad &load) const override {
+        if (top.empty())
+            return "";
+        stringstream ss;
+        ss << "top servers selected: ";
+        for (int serverIndex : top)
+            ss << "Server" << serverIndex << "(" << load.reputation[serverIndex] << ") ";
+        return ss.str();
+    }
+
+  private:
+    vector<int> top;      // Best first.
+    int next = 0;         // Rank the next subtask starts at.
+    vector<int> pool;
+};
+
+/*
+ * Power of two choices
+ * --------------------
+ * For each replica, two distinct random candidates are compared and the one with
+ * the lower load (outstanding + reported queue length) is taken.
+ */
+class PowerOfTwoSelector : public ReplicaSelector {
+  public:
+    virtual const char *getName() const override { return "power-of-two"; }
+
+    virtual void select(const ServerLoad &load, int count, cRNG *rng, vector<int> &chosen) override {
+        remainingCandidates(load, chosen, pool);
+        for (int r = 0; r < count && !pool.empty(); r++) {
+            int n = pool.size();
+            int a = intuniform(rng, 0, n - 1);
+            int pick = a;
+            if (n > 1) {
+                int b = intuniform(rng, 0, n - 2);
+                if (b >= a)
+                    b++;
+                if (load.load(pool[b]) < load.load(pool[a]))
+                    pick = b;
+            }
+            chosen.push_back(pool[pick]);
+            pool[pick] = pool.back();
+            pool.pop_back();
+        }
+    }
+
+  private:
+    vector<int> pool;
+};
+
+/*
+ * Least outstanding
+ * -----------------
+ * The 'count' candidates with the lowest load; ties are broken at random so that
+ * idle servers share the work evenly.
+ */
+class LeastOutstandingSelector : public ReplicaSelector {
+  public:
+    virtual const char *getName() const override { return "least-outstanding"; }
+
+    virtual void select(const ServerLoad &load, int count, cRNG *rng, vector<int> &chosen) override {
+        remainingCandidates(load, chosen, pool);
+        int n = pool.size();
+        count = min(count, n);
+        for (int i = n - 1; i > 0; i--)
+            swap(pool[i], pool[intuniform(rng, 0, i)]);
+        partial_sort(pool.begin(), pool.begin() + count, pool.end(),
+                     [&load](int a, int b) { return load.load(a) < load.load(b); });
+        chosen.insert(chosen.end(), pool.begin(), pool.begin() + count);
+    }
+
+  private:
+    vector<int> pool;
+};
+
+/*
+ * Reputation-weighted
+ * -------------------
+ * Samples without replacement with probability proportional to 1 + reputation
+ * (negative reputations count as 0), so trusted servers get most of the work
+ * without all of it going to the same few.
+ */
+class ReputationWeightedSelector : public ReplicaSelector {
+  public:
+    virtual const char *getName() const override { return "reputation-weighted"; }
+
+    virtual void select(const ServerLoad &load, int count, cRNG *rng, vector<int> &chosen) override {
+        remainingCandidates(load, chosen, pool);
+        weights.resize(pool.size());
+        double total = 0;
+        for (size_t i = 0; i < pool.size(); i++) {
+            weights[i] = 1 + (load.reputationKnown ? max(0.0, load.reputation[pool[i]]) : 0.0);
+            total += weights[i];
+        }
+        for (int r = 0; r < count && !pool.empty(); r++) {
+            double x = uniform(rng, 0, total);
+            size_t pick = 0;
+            while (pick + 1 < pool.size() && x >= weights[pick]) {
+                x -= weights[pick];
+                pick++;
+            }
+            chosen.push_back(pool[pick]);
+            total -= weights[pick];
+            pool[pick] = pool.back();
+            pool.pop_back();
+            weights[pick] = weights.back();
+            weights.pop_back();
+        }
+    }
+
+  private:
+    vector<int> pool;
+    vector<double> weights;
+};
+
+template <class T>
+static ReplicaSelector *create() {
+    return new T();
+}
+
+static map<string, ReplicaSelectorFactory> &registry() {
+    static map<string, ReplicaSelectorFactory> factories = {
+        {"top", create<TopSelector>},
+        {"uniform", create<UniformSelector>},
+        {"power-of-two", create<PowerOfTwoSelector>},
+        {"least-outstanding", create<LeastOutstandingSelector>},
+        {"reputation-weighted", create<ReputationWeightedSelector>},
+    };
+    return factories;
+}
+
+void registerReplicaSelector(const string &name, ReplicaSelectorFactory factory) {
+    registry()[name] = factory;
+}
+
+ReplicaSelector *createReplicaSelector(const string &name) {
+    auto it = registry().find(name);
+    if (it == registry().end())
+        throw cRuntimeError("Unknown replica selection policy '%s'", name.c_str());
+    return it->second();
+}
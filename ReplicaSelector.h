@@ -0,0 +1,88 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _REPLICASELECTOR_H
+#define _REPLICASELECTOR_H
+
+#include <omnetpp.h>
+#include <string>
+#include <vector>
+using namespace omnetpp;
+using namespace std;
+
+/**
+ * @brief What a client knows about the servers it may send a subtask to.
+ *
+ * 'outstanding' is tracked by the client itself (requests sent and neither
+ * answered nor cancelled); 'queueLength' is the queue length the server
+ * reported with its last response. All per-server vectors are indexed by the
+ * server's index in s[].
+ */
+struct ServerLoad {
+    vector<int> servers;          // Linked servers, sorted: the candidates.
+    vector<int> outstanding;      // Requests in flight to each server.
+    vector<int> queueLength;      // Queue length piggybacked on each server's last response.
+    vector<double> reputation;    // Merged reputation of each linked server, refreshed every round.
+    bool reputationKnown = false; // Some score or gossip has been merged into 'reputation'.
+
+    int load(int serverIndex) const { return outstanding[serverIndex] + queueLength[serverIndex]; }
+};
+
+/**
+ * @brief Policy that picks the servers a subtask is replicated on.
+ *
+ * The client calls beginRound() once before assigning the subtasks of a round
+ * and select() once per subtask. Policies are registered by name like the
+ * reduction operations (see ComputeKernels.h) and chosen with the client's
+ * 'replicaSelection' parameter. Built-in policies:
+ *   top                 - uniform until reputation is known, then the top servers by
+ *                         reputation (the original behaviour, and the default),
+ *   uniform             - a uniform sample of the linked servers,
+ *   power-of-two        - for each replica, the less loaded of two random servers,
+ *   least-outstanding   - the least loaded servers,
+ *   reputation-weighted - a sample with probability proportional to 1 + reputation.
+ */
+class ReplicaSelector {
+  public:
+    virtual ~ReplicaSelector() {}
+
+    /**
+     * @brief Name under which the policy is registered.
+     */
+    virtual const char *getName() const = 0;
+
+    /**
+     * @brief Prepares the selections of a round (e.g. ranks the servers once).
+     */
+    virtual void beginRound(const ServerLoad &load) {}
+
+    /**
+     * @brief Appends min(count, number of candidates) distinct servers to 'chosen'.
+     *
+     * Servers already in 'chosen' are not candidates, so a subtask's replicas can
+     * also be picked one call at a time (adaptive replication does).
+     */
+    virtual void select(const ServerLoad &load, int count, cRNG *rng, vector<int> &chosen) = 0;
+
+    /**
+     * @brief One-line description of the round's ranking for the client log ("" if none).
+     */
+    virtual string roundSummary(const ServerLoad &load) const { return ""; }
+};
+
+typedef ReplicaSelector *(*ReplicaSelectorFactory)();
+
+/**
+ * @brief Adds a policy to the registry. The built-in policies are registered automatically.
+ */
+void registerReplicaSelector(const string &name, ReplicaSelectorFactory factory);
+
+/**
+ * @brief Creates the registered policy 'name'; the caller owns it.
+ *        Throws cRuntimeError if no such policy exists.
+ */
+ReplicaSelector *createReplicaSelector(const string &name);
+
+#endif // _REPLICASELECTOR_H
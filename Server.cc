@@ -10,68 +10,498 @@
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
-#include <fstream>
 #include <vector>
 using namespace omnetpp;
 using namespace std;
 
 Define_Module(Server);
 
-// Log a message to the server-specific log file.
-void Server::logToFile(const string &msg) {
-    stringstream filename;
-    filename << "server_" << getId() << "_log.txt";
-    ofstream logFile(filename.str().c_str(), ios::app);
-    if (logFile.is_open()) {
-        logFile << msg << endl;
-        logFile.close();
+// Queue a message for the server-specific log file.
+void Server::logToFile(const string &msg, LogLevel level) {
+    if (logFile && logEnabled(level))
+        logFile->write(msg);
+}
+
+Server::~Server() {
+    FileLogger::release(logFile);
+    delete operation;
+    cancelAndDelete(crashTimer);
+    for (cMessage *timer : endServiceMsgs)
+        cancelAndDelete(timer);
+    for (cMessage *work : inService)
+        delete work;
+    for (auto &pending : inFlight)
+        for (SubtaskRequest *follower : pending.second.followers)
+            delete follower;
+}
+
+int Server::priorityOf(cObject *work) {
+    if (SubtaskBatch *batch = dynamic_cast<SubtaskBatch *>(work))
+        return batch->getPriority();
+    return static_cast<SubtaskRequest *>(work)->getPriority();
+}
+
+int Server::comparePriority(cObject *a, cObject *b) {
+    return priorityOf(a) - priorityOf(b);
+}
+
+size_t Server::elementsOf(cMessage *work) const {
+    if (SubtaskBatch *batch = dynamic_cast<SubtaskBatch *>(work)) {
+        // Batch entries whose result is already cached cost no computation.
+        size_t elements = 0;
+        for (size_t i = 0; i < batch->getEntriesArraySize(); i++) {
+            const BatchEntry &entry = batch->getEntries(i);
+            if (!resultCache.enabled() || !resultCache.contains(entry.contentKey, entry.data))
+                elements += entry.data.size();
+        }
+        return elements;
     }
+    return check_and_cast<SubtaskRequest *>(work)->getData().size();
 }
 
 void Server::initialize() {
     isMalicious = par("isMalicious");
+    logLevel = parseLogLevel(par("logLevel").stringValue());
+    if (logEnabled(LOG_ERROR))
+        logFile = FileLogger::acquire("server_" + to_string(getId()) + "_log.txt");
+    KernelParams kernelParams;
+    kernelParams.selectK = par("selectK");
+    kernelParams.histogramBins = par("histogramBins");
+    kernelParams.histogramMin = par("histogramMin");
+    kernelParams.histogramMax = par("histogramMax");
+    operation = createReductionOp(par("operation").stdstringValue(), kernelParams);
+
+    // Set up the worker slots and the request queue.
+    numWorkers = par("numWorkers");
+    if (numWorkers < 1)
+        throw cRuntimeError("numWorkers must be at least 1 (got %d)", numWorkers);
+    speed = par("speed");
+    if (speed <= 0)
+        throw cRuntimeError("speed must be positive (got %g)", speed);
+    queue.setName("queue");
+    priorityQueue = strcmp(par("queueDiscipline").stringValue(), "priority") == 0;
+    if (priorityQueue)
+        queue.setup(comparePriority);
+    inService.assign(numWorkers, nullptr);
+    serviceRates.assign(numWorkers, 0);
+    for (int i = 0; i < numWorkers; i++)
+        endServiceMsgs.push_back(new cMessage("EndService", i));
+    for (int i = numWorkers - 1; i >= 0; i--)
+        freeWorkers.push_back(i);   // Slot 0 is handed out first.
+    queueLengthSignal = registerSignal("queueLength");
+    waitingTimeSignal = registerSignal("waitingTime");
+    responseTimeSignal = registerSignal("responseTime");
+    utilizationSignal = registerSignal("utilization");
+    cancelledQueuedSignal = registerSignal("cancelledQueued");
+    cancelledInServiceSignal = registerSignal("cancelledInService");
+    requestsReceivedSignal = registerSignal("requestsReceived");
+
+    // Result cache and sharing of identical in-flight requests.
+    int cacheSize = par("resultCacheSize");
+    if (cacheSize < 0)
+        throw cRuntimeError("resultCacheSize must not be negative, got %d", cacheSize);
+    resultCache.resize(cacheSize);
+    cachePoison = par("cachePoison");
+    cacheHitSignal = registerSignal("cacheHit");
+    cacheMissSignal = registerSignal("cacheMiss");
+    cacheEvictionSignal = registerSignal("cacheEviction");
+    dedupJoinedSignal = registerSignal("dedupJoined");
+    emit(queueLengthSignal, 0);
+    emit(utilizationSignal, 0.0);
+
+    // Fault injection: crash-stop at 'crashTime', lost requests and delayed responses.
+    dropProbability = par("dropProbability");
+    delayProbability = par("delayProbability");
+    faultDroppedSignal = registerSignal("faultDropped");
+    faultDelayedSignal = registerSignal("faultDelayed");
+    allocationsSignal = registerSignal("allocations");
+    simtime_t crashTime = par("crashTime");
+    if (crashTime >= SIMTIME_ZERO) {
+        crashTimer = new cMessage("Crash");
+        scheduleAt(crashTime, crashTimer);
+    }
+
     stringstream initMsg;
     initMsg << "Server " << getId() << " initialized as "
-            << (isMalicious ? "Malicious" : "Honest") << ".";
+            << (isMalicious ? "Malicious" : "Honest") << ". Operation: "
+            << operation->getName() << " (" << kernelIsaName() << " kernels).";
     EV << initMsg.str() << "\n";
     logToFile(initMsg.str());
 }
 
 void Server::handleMessage(cMessage *msg) {
-    int subtaskId = msg->par("subtaskId");
-    const char* dataStr = msg->par("data").stringValue();
-    vector<int> numbers;
-    {
-      string s(dataStr);
-      stringstream ss(s);
-      string token;
-      while(getline(ss, token, ',')) {
-         numbers.push_back(atoi(token.c_str()));
-      }
-    }
-    int correctMax = *max_element(numbers.begin(), numbers.end());
-    int result;
-    stringstream compMsg;
-    if (isMalicious) {
-       result = (correctMax > 0) ? correctMax - 1 : 0;
-       compMsg << "Server " << getId() << " (Malicious) computed result " << result
-               << " for Subtask_" << subtaskId;
+    AllocationProbe probe(this, allocationsSignal);
+    if (msg == crashTimer) {
+        crash();
+        return;
+    }
+    if (msg->isSelfMessage()) {
+        endService(msg->getKind());
+        return;
+    }
+    // A crashed server is silent; a healthy one loses a request or batch with 'dropProbability'.
+    SubtaskCancel *cancel = dynamic_cast<SubtaskCancel *>(msg);
+    if (crashed || (!cancel && dropProbability > 0 && uniform(0, 1) < dropProbability)) {
+        if (!cancel)
+            emit(faultDroppedSignal, 1);
+        delete msg;
+        return;
+    }
+    if (cancel) {
+        cancelRequest(cancel);
+        delete cancel;
+        return;
+    }
+    // With the result cache on, every payload is hashed exactly once, here; the cache lookups,
+    // the in-flight table and the batch service time all use the stored key.
+    if (SubtaskRequest *req = dynamic_cast<SubtaskRequest *>(msg)) {
+        emit(requestsReceivedSignal, 1);
+        if (resultCache.enabled()) {
+            req->setContentKey(ResultCache::keyOf(req->getData()));
+            if (!admitRequest(req))
+                return;
+        }
+    }
+    else if (SubtaskBatch *batch = dynamic_cast<SubtaskBatch *>(msg)) {
+        emit(requestsReceivedSignal, (long)batch->getEntriesArraySize());
+        if (resultCache.enabled())
+            for (size_t k = 0; k < batch->getEntriesArraySize(); k++) {
+                BatchEntry &entry = batch->getEntriesForUpdate(k);
+                entry.contentKey = ResultCache::keyOf(entry.data);
+            }
+    }
+    else
+        throw cRuntimeError("Unexpected message '%s' (%s)", msg->getName(), msg->getClassName());
+    if (!freeWorkers.empty()) {
+        startService(msg);
+    } else {
+        queue.insert(msg);
+        emit(queueLengthSignal, queue.getLength());
+    }
+}
+
+void Server::startService(cMessage *work) {
+    int slot = freeWorkers.back();
+    freeWorkers.pop_back();
+    inService[slot] = work;
+    emit(waitingTimeSignal, simTime() - work->getArrivalTime());
+    emit(utilizationSignal, (double)(numWorkers - freeWorkers.size()) / numWorkers);
+
+    // Service time grows with the subtask size (for a batch, the size of all its subtasks);
+    // both terms are fresh draws of volatile parameters, scaled by the server's speed.
+    size_t elements = elementsOf(work);
+    double serviceTime = (par("serviceTimeBase").doubleValue()
+            + elements * par("serviceTimePerElement").doubleValue()) / speed;
+    serviceRates[slot] = serviceTime > 0 ? elements / serviceTime : 0;
+    scheduleAt(simTime() + serviceTime, endServiceMsgs[slot]);
+}
+
+void Server::endService(int slot) {
+    cMessage *work = inService[slot];
+    inService[slot] = nullptr;
+    freeWorkers.push_back(slot);
+    emit(responseTimeSignal, simTime() - work->getArrivalTime());
+    if (SubtaskBatch *batch = dynamic_cast<SubtaskBatch *>(work))
+        processBatch(batch, serviceRates[slot]);
+    else
+        processRequest(check_and_cast<SubtaskRequest *>(work), serviceRates[slot]);
+
+    if (!queue.isEmpty()) {
+        cMessage *next = check_and_cast<cMessage *>(queue.pop());
+        emit(queueLengthSignal, queue.getLength());
+        startService(next);
     } else {
-       result = correctMax;
-       compMsg << "Server " << getId() << " (Honest) computed result " << result
-               << " for Subtask_" << subtaskId;
-    }
-    EV << compMsg.str() << "\n";
-    logToFile(compMsg.str());
-    stringstream sendMsg;
-    sendMsg << "Server " << getId() << " sending Response for Subtask_" << subtaskId;
-    EV << sendMsg.str() << "\n";
-    logToFile(sendMsg.str());
-    cMessage *response = new cMessage("Response");
-    response->addPar("subtaskId") = subtaskId;
-    response->addPar("result") = result;
-    response->addPar("serverId") = getId();
-    response->addPar("serverType") = isMalicious ? "Malicious" : "Honest";
-    send(response, "out", msg->getArrivalGate()->getIndex());
-    delete msg;
+        emit(utilizationSignal, (double)(numWorkers - freeWorkers.size()) / numWorkers);
+    }
+}
+
+void Server::cancelRequest(SubtaskCancel *cancel) {
+    // A request matches if it came over the same client connection for the same job, subtask and round.
+    int client = cancel->getArrivalGate()->getIndex();
+    auto matches = [&](int jobId, int subtaskId, int round) {
+        return jobId == cancel->getJobId() && subtaskId == cancel->getSubtaskId() && round == cancel->getRound();
+    };
+
+    // A request waiting for an identical in-flight one is simply taken off its list.
+    for (auto &pending : inFlight) {
+        vector<SubtaskRequest *> &followers = pending.second.followers;
+        for (auto it = followers.begin(); it != followers.end(); ++it) {
+            SubtaskRequest *req = *it;
+            if (req->getArrivalGate()->getIndex() == client && matches(req->getJobId(), req->getSubtaskId(), req->getRound())) {
+                followers.erase(it);
+                delete req;
+                emit(cancelledQueuedSignal, 1);
+                return;
+            }
+        }
+    }
+
+    for (int i = 0; i < queue.getLength(); i++) {
+        cMessage *work = check_and_cast<cMessage *>(queue.get(i));
+        if (work->getArrivalGate()->getIndex() != client)
+            continue;
+        if (SubtaskBatch *batch = dynamic_cast<SubtaskBatch *>(work)) {
+            for (size_t k = 0; k < batch->getEntriesArraySize(); k++) {
+                const BatchEntry &entry = batch->getEntries(k);
+                if (matches(entry.jobId, entry.subtaskId, entry.round)) {
+                    batch->eraseEntries(k);
+                    if (batch->getEntriesArraySize() == 0) {
+                        delete queue.remove(batch);
+                        emit(queueLengthSignal, queue.getLength());
+                    }
+                    emit(cancelledQueuedSignal, 1);
+                    return;
+                }
+            }
+        } else {
+            SubtaskRequest *req = check_and_cast<SubtaskRequest *>(work);
+            if (matches(req->getJobId(), req->getSubtaskId(), req->getRound())) {
+                // Identical requests waiting for this one keep its place in the queue; a sorted
+                // queue puts the successor where its own priority belongs.
+                if (SubtaskRequest *successor = releaseLeader(req)) {
+                    if (priorityQueue)
+                        queue.insert(successor);
+                    else
+                        queue.insertBefore(req, successor);
+                }
+                queue.remove(req);
+                delete req;
+                emit(queueLengthSignal, queue.getLength());
+                emit(cancelledQueuedSignal, 1);
+                return;
+            }
+        }
+    }
+    for (int slot = 0; slot < numWorkers; slot++) {
+        // Only single requests are aborted; a batch in service also serves other subtasks.
+        SubtaskRequest *req = dynamic_cast<SubtaskRequest *>(inService[slot]);
+        if (req && req->getArrivalGate()->getIndex() == client
+            && matches(req->getJobId(), req->getSubtaskId(), req->getRound())) {
+            // If identical requests wait for this computation, it continues on their behalf.
+            if (SubtaskRequest *successor = releaseLeader(req)) {
+                inService[slot] = successor;
+                delete req;
+                emit(cancelledInServiceSignal, SIMTIME_ZERO);
+                return;
+            }
+            emit(cancelledInServiceSignal, endServiceMsgs[slot]->getArrivalTime() - simTime());
+            cancelEvent(endServiceMsgs[slot]);
+            inService[slot] = nullptr;
+            freeWorkers.push_back(slot);
+            delete req;
+            if (!queue.isEmpty()) {
+                cMessage *next = check_and_cast<cMessage *>(queue.pop());
+                emit(queueLengthSignal, queue.getLength());
+                startService(next);
+            } else {
+                emit(utilizationSignal, (double)(numWorkers - freeWorkers.size()) / numWorkers);
+            }
+            return;
+        }
+    }
+    // Already answered: nothing left to drop.
+}
+
+bool Server::admitRequest(SubtaskRequest *req) {
+    const SubtaskData &data = req->getData();
+    uint64_t key = req->getContentKey();
+    if (const KernelResult *cached = resultCache.find(key, data)) {
+        emit(cacheHitSignal, 1);
+        emit(responseTimeSignal, SIMTIME_ZERO);
+        if (logEnabled(LOG_DEBUG))
+            logToFile("Server " + to_string(getId()) + " answering Subtask_" + to_string(req->getSubtaskId())
+                      + " from the result cache", LOG_DEBUG);
+        sendResponse(req, *cached, cachedResultCorrupted());
+        return false;
+    }
+    auto it = inFlight.find(key);
+    if (it == inFlight.end()) {
+        inFlight[key].leader = req;
+        return true;
+    }
+    if (ResultCache::sameContent(it->second.leader->getData(), data)) {
+        it->second.followers.push_back(req);
+        emit(dedupJoinedSignal, 1);
+        return false;
+    }
+    return true;   // Hash collision with a different payload: computed on its own.
+}
+
+SubtaskRequest *Server::releaseLeader(SubtaskRequest *req) {
+    if (!resultCache.enabled())
+        return nullptr;
+    auto it = inFlight.find(req->getContentKey());
+    if (it == inFlight.end() || it->second.leader != req)
+        return nullptr;
+    vector<SubtaskRequest *> &followers = it->second.followers;
+    if (followers.empty()) {
+        inFlight.erase(it);
+        return nullptr;
+    }
+    SubtaskRequest *successor = followers.front();
+    followers.erase(followers.begin());
+    it->second.leader = successor;
+    return successor;
+}
+
+KernelResult Server::computeResult(const SubtaskData &data, uint64_t key, bool &corrupted) {
+    if (resultCache.enabled()) {
+        if (const KernelResult *cached = resultCache.find(key, data)) {
+            emit(cacheHitSignal, 1);
+            corrupted = cachedResultCorrupted();
+            return *cached;
+        }
+        emit(cacheMissSignal, 1);
+    }
+    // Read the elements in place from the client's shared buffer.
+    KernelResult result = operation->reduce(data.begin(), data.size());
+    // Only a poisoning malicious server caches its wrong answer (and repeats it on every hit);
+    // otherwise the cache keeps the true value and a malicious server lies only when it computes.
+    if (isMalicious && cachePoison)
+        corrupt(result);
+    if (resultCache.enabled() && resultCache.insert(key, data, result))
+        emit(cacheEvictionSignal, 1);
+    if (isMalicious && !cachePoison)
+        corrupt(result);
+    corrupted = isMalicious;
+    return result;
+}
+
+void Server::corrupt(KernelResult &result) {
+    // Malicious servers report every value off by one.
+    for (auto &v : result)
+        v = (v > 0) ? v - 1 : 0;
+}
+
+int Server::witnessOf(const SubtaskData &data, const KernelResult &result) {
+    // A malicious server's off-by-one value only has a witness if it happens to occur in the subtask.
+    if (result.size() != 1)
+        return -1;
+    const int *found = find(data.begin(), data.end(), result[0]);
+    return found != data.end() ? found - data.begin() : -1;
+}
+
+void Server::processRequest(SubtaskRequest *req, double serviceRate) {
+    int subtaskId = req->getSubtaskId();
+    bool corrupted;
+    KernelResult result = computeResult(req->getData(), req->getContentKey(), corrupted);
+    if (traceEnabled(LOG_INFO)) {
+        stringstream compMsg;
+        compMsg << "Server " << getId() << (isMalicious ? " (Malicious)" : " (Honest)")
+                << " computed result " << resultToString(result) << " for Subtask_" << subtaskId;
+        EV << compMsg.str() << "\n";
+        logToFile(compMsg.str());
+    }
+
+    // Identical requests that arrived meanwhile get the same result (but did not measure the service).
+    if (resultCache.enabled()) {
+        auto it = inFlight.find(req->getContentKey());
+        if (it != inFlight.end() && it->second.leader == req) {
+            for (SubtaskRequest *follower : it->second.followers) {
+                emit(responseTimeSignal, simTime() - follower->getArrivalTime());
+                sendResponse(follower, result, corrupted);
+            }
+            inFlight.erase(it);
+        }
+    }
+    sendResponse(req, result, corrupted, serviceRate);
+}
+
+void Server::sendResponse(SubtaskRequest *req, const KernelResult &result, bool corrupted, double serviceRate) {
+    if (traceEnabled(LOG_DEBUG)) {
+        stringstream sendMsg;
+        sendMsg << "Server " << getId() << " sending Response for Subtask_" << req->getSubtaskId();
+        EV << sendMsg.str() << "\n";
+        logToFile(sendMsg.str(), LOG_DEBUG);
+    }
+    // The request itself travels back as the response: no message is allocated per answer,
+    // and the client recycles it for its next requests.
+    int gateIndex = req->getArrivalGate()->getIndex();
+    if (req->getWitness())
+       req->setWitnessPosition(witnessOf(req->getData(), result));
+    req->setName("Response");
+    req->setData(SubtaskData());   // The client does not need its own subarray back.
+    req->setResultArraySize(result.size());
+    for (int i = 0; i < (int)result.size(); i++)
+       req->setResult(i, result[i]);
+    req->setServerId(getId());
+    req->setServerIndex(getIndex());
+    req->setMalicious(isMalicious);
+    req->setCorrupted(corrupted);
+    req->setQueueLength(queue.getLength());
+    req->setServiceRate(serviceRate);
+    sendResult(req, gateIndex);
+}
+
+void Server::processBatch(SubtaskBatch *batch, double serviceRate) {
+    int numEntries = batch->getEntriesArraySize();
+    BatchResponse *response = new BatchResponse("BatchResponse");
+    response->setServerId(getId());
+    response->setServerIndex(getIndex());
+    response->setMalicious(isMalicious);
+    response->setQueueLength(queue.getLength());
+    response->setServiceRate(serviceRate);
+    response->setEntriesArraySize(numEntries);
+    for (int k = 0; k < numEntries; k++) {
+       const BatchEntry &entry = batch->getEntries(k);
+       bool corrupted;
+       KernelResult result = computeResult(entry.data, entry.contentKey, corrupted);
+       BatchResult &answer = response->getEntriesForUpdate(k);
+       answer.jobId = entry.jobId;
+       answer.subtaskId = entry.subtaskId;
+       answer.round = entry.round;
+       answer.offset = response->getResultsArraySize();
+       answer.length = result.size();
+       answer.witness = entry.witness ? witnessOf(entry.data, result) : -1;
+       answer.corrupted = corrupted;
+       for (int64_t v : result)
+          response->appendResults(v);
+       if (logEnabled(LOG_DEBUG)) {
+          stringstream compMsg;
+          compMsg << "Server " << getId() << (isMalicious ? " (Malicious)" : " (Honest)")
+                  << " computed result " << resultToString(result) << " for Job " << entry.jobId
+                  << " Subtask_" << entry.subtaskId << " (batched)";
+          logToFile(compMsg.str(), LOG_DEBUG);
+       }
+    }
+    if (traceEnabled(LOG_INFO)) {
+        stringstream sendMsg;
+        sendMsg << "Server " << getId() << (isMalicious ? " (Malicious)" : " (Honest)")
+                << " sending BatchResponse for " << numEntries << " subtasks";
+        EV << sendMsg.str() << "\n";
+        logToFile(sendMsg.str());
+    }
+    sendResult(response, batch->getArrivalGate()->getIndex());
+    delete batch;
+}
+
+void Server::sendResult(cMessage *response, int gateIndex) {
+    if (delayProbability > 0 && uniform(0, 1) < delayProbability) {
+        simtime_t delay = par("delayTime");
+        emit(faultDelayedSignal, delay);
+        sendDelayed(response, delay, "out", gateIndex);
+    } else {
+        send(response, "out", gateIndex);
+    }
+}
+
+void Server::crash() {
+    crashed = true;
+    for (int slot = 0; slot < numWorkers; slot++) {
+        cancelEvent(endServiceMsgs[slot]);
+        delete inService[slot];
+        inService[slot] = nullptr;
+    }
+    int lost = queue.getLength();
+    queue.clear();
+    for (auto &pending : inFlight)
+        for (SubtaskRequest *follower : pending.second.followers)
+            delete follower;
+    inFlight.clear();
+    emit(queueLengthSignal, 0);
+    emit(utilizationSignal, 0.0);
+    stringstream crashMsg;
+    crashMsg << "Server " << getId() << " crashed; " << lost << " queued requests lost";
+    EV << crashMsg.str() << "\n";
+    logToFile(crashMsg.str());
 }
@@ -7,6 +7,13 @@
 #define _ASSIGNMENT_A_H
 
 #include <omnetpp.h>
+#include <vector>
+#include "TaskMessages_m.h"
+#include "Logger.h"
+#include "ComputeKernels.h"
+#include "ResultCache.h"
+#include "AllocationCounter.h"
+#include <unordered_map>
 using namespace omnetpp;
 using namespace std;
 
@@ -16,35 +23,224 @@ using namespace std;
  * This class models a server that processes incoming messages.
  * It includes functionality to determine whether the server behaves
  * maliciously or honestly.
+ *
+ * Requests are served by 'numWorkers' worker slots. A request that finds all
+ * workers busy waits in a FIFO or priority queue (cQueue). Serving a request
+ * takes serviceTimeBase + (number of elements) * serviceTimePerElement, both
+ * drawn from their (volatile) NED parameters, and the response is sent when
+ * the service completes. A server with 'speed' s serves s times as fast as
+ * the base times say, and reports the elements per second it achieved with
+ * each response so that clients can learn its speed. Queue length, waiting time, utilization and response
+ * time are emitted as signals (see the @statistic declarations in myNetwork.ned),
+ * as is the number of requests received.
+ *
+ * A SubtaskBatch is one unit of work: it occupies a single worker slot, pays
+ * serviceTimeBase once plus the per-element time for the elements of all its
+ * entries, and is answered with one coalesced BatchResponse.
+ *
+ * With 'resultCacheSize' > 0, results are kept in an LRU ResultCache keyed by
+ * the subtask content. A request whose payload is cached is answered at once
+ * without occupying a worker, and a request identical to one already queued or
+ * in service waits for that computation instead of being computed again.
+ * Batch entries are looked up individually; cached ones add no service time.
+ *
+ * For fault-tolerance experiments a server can crash for good at 'crashTime'
+ * (queued and in-service work is lost and every later message ignored), lose
+ * an arriving request or batch with 'dropProbability', and hold back a response
+ * by 'delayTime' with 'delayProbability'.
+ *
+ * A request may ask for a witness of its result (see Client's 'verification'
+ * parameter), which the server returns along with the value.
+ *
+ * A request is answered by filling its result fields and sending it back, so
+ * the hot path allocates no response messages; trace strings are only built
+ * when the file log or the Qtenv/Cmdenv event log will show them.
  */
 class Server : public cSimpleModule {
   private:
     // Flag to indicate if this server is malicious.
     bool isMalicious;
-    
+
+    // Operation applied to every subtask, selected by the 'operation' parameter.
+    ReductionOp *operation = nullptr;
+
+    // Queueing model: worker slots and the queue of requests waiting for one.
+    int numWorkers;
+    cQueue queue;                           // Waiting SubtaskRequests and SubtaskBatches.
+    bool priorityQueue;                     // The queue is sorted by priority rather than FIFO.
+    vector<cMessage *> inService;           // Work served by each worker slot (nullptr if idle).
+    vector<cMessage *> endServiceMsgs;      // Completion timer of each worker slot (kind = slot).
+    vector<int> freeWorkers;                // Indices of the idle worker slots.
+    vector<double> serviceRates;            // Elements per second of each slot's current service.
+    double speed;                           // Relative speed: service times are divided by it.
+
+    // Statistics signals.
+    simsignal_t queueLengthSignal;
+    simsignal_t waitingTimeSignal;
+    simsignal_t responseTimeSignal;
+    simsignal_t utilizationSignal;
+    simsignal_t cancelledQueuedSignal;      // A queued request was dropped by a SubtaskCancel.
+    simsignal_t cancelledInServiceSignal;   // An in-service request was aborted; value = service time saved.
+    simsignal_t requestsReceivedSignal;     // Requests received (a batch counts its entries).
+
+    // Result cache and the requests sharing an in-flight computation.
+    struct InFlight {
+        SubtaskRequest *leader = nullptr;       // The request that is queued or in service.
+        vector<SubtaskRequest *> followers;     // Identical requests answered with its result.
+    };
+    ResultCache resultCache;
+    bool cachePoison;                       // Malicious server stores its wrong results in the cache.
+    unordered_map<uint64_t, InFlight> inFlight;   // By content key of the leader's payload.
+    simsignal_t cacheHitSignal;
+    simsignal_t cacheMissSignal;
+    simsignal_t cacheEvictionSignal;
+    simsignal_t dedupJoinedSignal;          // A request joined an identical in-flight computation.
+
+    // Fault injection.
+    cMessage *crashTimer = nullptr;         // Fires at 'crashTime' (none if the server never crashes).
+    bool crashed = false;                   // After the crash every message is dropped.
+    double dropProbability;                 // Chance that an arriving request or batch is lost.
+    double delayProbability;                // Chance that a response is held back by 'delayTime'.
+    simsignal_t faultDroppedSignal;         // A request or batch was lost (dropped or sent to a crashed server).
+    simsignal_t faultDelayedSignal;         // A response was delayed; value = the extra delay.
+    simsignal_t allocationsSignal;          // Heap allocations per event (needs COUNT_ALLOCS=1, see AllocationCounter.h).
+
+    // Verbosity of the file log and the buffered handle for server_<id>_log.txt.
+    LogLevel logLevel;
+    FileLogger *logFile = nullptr;
+
     /**
      * @brief Logs messages to a dedicated server-specific log file.
      * 
-     * Each server maintains a separate log file identified by its ID.
+     * Each server maintains a separate log file identified by its ID. The file
+     * stays open and is written in batches by the shared FileLogger writer;
+     * messages above the configured 'logLevel' are dropped.
      * @param msg The message to be logged.
+     * @param level Verbosity of the message.
+     */
+    void logToFile(const string &msg, LogLevel level = LOG_INFO);
+
+    bool logEnabled(LogLevel level) const { return FILE_LOG_ENABLED && level <= logLevel; }
+
+    // True if a trace line at 'level' goes to the file log or to EV (off in Cmdenv express mode).
+    bool traceEnabled(LogLevel level) const { return logEnabled(level) || getEnvir()->isLoggingEnabled(); }
+
+    /**
+     * @brief Assigns a request or batch to an idle worker slot and schedules its completion.
+     */
+    void startService(cMessage *work);
+
+    /**
+     * @brief Completes the work of a worker slot and starts the next queued one.
+     */
+    void endService(int slot);
+
+    /**
+     * @brief Drops the queued or in-service request matched by a SubtaskCancel.
+     *
+     * A matching entry of a queued batch is removed from it (and the batch
+     * dropped once empty). A batch already in service is not split up.
+     */
+    void cancelRequest(SubtaskCancel *cancel);
+
+    /**
+     * @brief Answers a request from the cache or attaches it to an identical in-flight request.
+     * @return true if the request still has to be served (it is then the in-flight leader).
+     */
+    bool admitRequest(SubtaskRequest *req);
+
+    /**
+     * @brief Called when an in-flight leader is cancelled: hands its computation to the first
+     *        follower, which is returned, or forgets the entry and returns nullptr.
+     */
+    SubtaskRequest *releaseLeader(SubtaskRequest *req);
+
+    /**
+     * @brief Computes the result of a request and sends the Response (also to the requests
+     *        waiting for the same payload).
+     */
+    void processRequest(SubtaskRequest *req, double serviceRate);
+
+    /**
+     * @brief Turns the request into the Response carrying 'result' and sends it back.
+     *        'corrupted' tells whether the result is wrong; 'serviceRate' is the elements per
+     *        second of its service (0 if it was not served).
+     */
+    void sendResponse(SubtaskRequest *req, const KernelResult &result, bool corrupted, double serviceRate = 0);
+
+    /**
+     * @brief Computes the results of all entries of a batch, sends one BatchResponse and deletes the batch.
+     */
+    void processBatch(SubtaskBatch *batch, double serviceRate);
+
+    /**
+     * @brief Sends a Response or BatchResponse on out[gateIndex], delayed if the delay fault strikes.
+     */
+    void sendResult(cMessage *response, int gateIndex);
+
+    /**
+     * @brief Crash-stop: discards all queued and in-service work; later messages are dropped.
+     */
+    void crash();
+
+    /**
+     * @brief Result of a subtask from the cache, or from the configured operation (off by one
+     *        if this server is malicious). 'key' is the contentKey stored on arrival;
+     *        'corrupted' is set if the returned result is wrong.
+     */
+    KernelResult computeResult(const SubtaskData &data, uint64_t key, bool &corrupted);
+
+    /**
+     * @brief Whether a result taken from the cache is wrong: only a poisoning malicious server caches lies.
+     */
+    bool cachedResultCorrupted() const { return isMalicious && cachePoison; }
+
+    static void corrupt(KernelResult &result);
+
+    /**
+     * @brief Witness of a single-value result: the position of the first element of the
+     *        subtask equal to it, or -1 if there is none.
+     */
+    static int witnessOf(const SubtaskData &data, const KernelResult &result);
+
+    /**
+     * @brief Number of elements a request or batch needs to compute (cached batch entries excluded).
+     */
+    size_t elementsOf(cMessage *work) const;
+
+    /**
+     * @brief Scheduling priority of a queued request or batch.
+     */
+    static int priorityOf(cObject *work);
+
+    /**
+     * @brief Orders the priority queue: lower 'priority' first, FIFO among equals.
+     */
+    static int comparePriority(cObject *a, cObject *b);
+
+  public:
+    /**
+     * @brief Releases the log file handle, the operation and any pending requests.
      */
-    void logToFile(const string &msg);
+    virtual ~Server();
 
   protected:
     /**
      * @brief Initializes the server module.
      * 
-     * Determines if the server is malicious or honest based on parameters.
-     * Logs initialization details.
+     * Determines if the server is malicious or honest based on parameters,
+     * creates the configured operation, sets up the worker slots and queue,
+     * and logs initialization details.
      */
     virtual void initialize() override;
     
     /**
      * @brief Handles incoming messages.
      * 
-     * Processes incoming computational tasks and determines results
-     * based on the server's behavior (malicious/honest). 
-     * Logs computations and sends responses accordingly.
+     * Queues incoming computational tasks (single requests or batches) or hands them to an idle worker, and
+     * drops the work of requests a client has cancelled; on a
+     * worker's completion timer, computes the result with the configured operation
+     * based on the server's behavior (malicious/honest), logs it and sends the response.
      * @param msg The incoming message to be processed.
      */
     virtual void handleMessage(cMessage *msg) override;
@@ -0,0 +1,61 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _SMALLVECTOR_H
+#define _SMALLVECTOR_H
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+using namespace std;
+
+/**
+ * @brief Vector with inline storage for the first N elements.
+ *
+ * Used for short-lived scratch lists on the hot path (e.g. the vote tally of a
+ * subtask, which almost always holds one or two distinct values): as long as
+ * no more than N elements are added, no heap allocation takes place. Only
+ * trivially copyable element types are supported.
+ */
+template <typename T, size_t N>
+class SmallVector {
+    static_assert(is_trivially_copyable<T>::value, "SmallVector only holds trivially copyable types");
+
+  public:
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T *begin() { return spilled() ? heap.data() : items; }
+    T *end() { return begin() + count; }
+    const T *begin() const { return spilled() ? heap.data() : items; }
+    const T *end() const { return begin() + count; }
+    T &operator[](size_t i) { return begin()[i]; }
+    const T &operator[](size_t i) const { return begin()[i]; }
+
+    void push_back(const T &value) {
+        if (count < N) {
+            items[count] = value;
+        } else {
+            if (count == N)
+                heap.assign(items, items + N);   // First overflow: move to the heap.
+            heap.push_back(value);
+        }
+        count++;
+    }
+
+    void clear() {
+        count = 0;
+        heap.clear();
+    }
+
+  private:
+    bool spilled() const { return count > N; }
+
+    T items[N];
+    vector<T> heap;
+    size_t count = 0;
+};
+
+#endif // _SMALLVECTOR_H
@@ -0,0 +1,129 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _SUBTASKDATA_H
+#define _SUBTASKDATA_H
+
+#include <omnetpp.h>
+#include <memory>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+using namespace std;
+
+/**
+ * @brief Immutable, reference-counted view of a subtask's elements.
+ *
+ * The client loads its input array once, either parsed into a shared buffer or
+ * memory-mapped from a binary file (see MappedArray), and describes every
+ * subtask as an (offset, length) view over it. SubtaskRequest messages
+ * carry a SubtaskData by value, so dup()-ing a request for each replica only
+ * copies the handle and bumps the reference count; the elements themselves
+ * are never copied. Servers read them in place through begin()/end().
+ *
+ * Under parallel simulation a request sent to another partition cannot share
+ * the buffer, so the parsim packing functions below transfer the elements and
+ * the receiving side gets a view over a buffer of its own.
+ */
+class SubtaskData {
+  public:
+    SubtaskData() : elements(nullptr), length(0) {}
+
+    /**
+     * @brief Creates a view of 'length' elements of 'array' starting at 'offset'.
+     */
+    SubtaskData(const shared_ptr<const vector<int>> &array, size_t offset, size_t length)
+        : owner(array), elements(array->data() + offset), length(length) {}
+
+    /**
+     * @brief Creates a view of 'length' elements at 'elements', kept alive by 'owner'
+     *        (any buffer holding them, e.g. a MappedArray).
+     */
+    SubtaskData(const shared_ptr<const void> &owner, const int *elements, size_t length)
+        : owner(owner), elements(elements), length(length) {}
+
+    const int *begin() const { return elements; }
+    const int *end() const { return elements + length; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    int operator[](size_t i) const { return elements[i]; }
+
+    // Number of handles sharing the underlying buffer (for diagnostics).
+    long useCount() const { return owner.use_count(); }
+
+    // Compact description used by the message descriptors in Qtenv.
+    string str() const {
+        stringstream ss;
+        ss << length << " elements";
+        if (length > 0)
+            ss << " [" << elements[0] << (length > 1 ? ", ..." : "") << "]";
+        return ss.str();
+    }
+
+  private:
+    shared_ptr<const void> owner;     // Keeps the underlying buffer alive.
+    const int *elements;              // First element of this view.
+    size_t length;                    // Number of elements in this view.
+};
+
+/**
+ * @brief Splits an input array into a fixed number of contiguous subtasks.
+ *
+ * Chunks are produced on demand as views, so nothing proportional to the
+ * array size is allocated or touched. Every chunk has size / numChunks
+ * elements, and the last one also takes the remainder.
+ */
+class SubtaskChunker {
+  public:
+    SubtaskChunker(const shared_ptr<const void> &owner, const int *elements, size_t size, size_t numChunks)
+        : owner(owner), elements(elements), total(size), numChunks(numChunks),
+          chunkSize(numChunks ? size / numChunks : 0) {}
+
+    size_t count() const { return numChunks; }
+
+    // Smallest chunk length (all chunks but the last have exactly this many elements).
+    size_t minChunkSize() const { return chunkSize; }
+
+    SubtaskData chunk(size_t i) const {
+        size_t start = i * chunkSize;
+        size_t end = (i == numChunks - 1) ? total : start + chunkSize;
+        return SubtaskData(owner, elements + start, end - start);
+    }
+
+  private:
+    shared_ptr<const void> owner;
+    const int *elements;
+    size_t total;
+    size_t numChunks;
+    size_t chunkSize;
+};
+
+/**
+ * @brief Parses a comma-separated list of integers (the client's 'arrayData') into 'array'.
+ *        Tokens are read with atoi, so a malformed token counts as 0.
+ */
+inline void parseArrayData(const string &text, vector<int> &array) {
+    stringstream ss(text);
+    string token;
+    while (getline(ss, token, ','))
+        array.push_back(atoi(token.c_str()));
+}
+
+// Parsim (de)serialization, called by the generated SubtaskRequest packing code.
+inline void doParsimPacking(omnetpp::cCommBuffer *buffer, const SubtaskData &data) {
+    buffer->pack((int)data.size());
+    buffer->pack(data.begin(), (int)data.size());
+}
+
+inline void doParsimUnpacking(omnetpp::cCommBuffer *buffer, SubtaskData &data) {
+    int length;
+    buffer->unpack(length);
+    shared_ptr<vector<int>> elements = make_shared<vector<int>>(length);
+    buffer->unpack(elements->data(), length);
+    data = SubtaskData(elements, elements->data(), length);
+}
+
+#endif // _SUBTASKDATA_H
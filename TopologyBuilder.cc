@@ -0,0 +1,137 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#include "TopologyBuilder.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+using namespace omnetpp;
+using namespace std;
+
+Define_Module(TopologyBuilder);
+
+/*
+ * Function: readTopologyFile
+ * --------------------------
+ *   Reads 'fileName' line by line. Every "Client <i>: ..." line appends its servers to
+ *   client i's list (a client may be listed on several lines); the lists are sorted and
+ *   de-duplicated at the end.
+ */
+vector<vector<int>> TopologyBuilder::readTopologyFile(const string &fileName, int numClients, int numServers) {
+    ifstream in(fileName);
+    if (!in)
+        throw cRuntimeError("Cannot open topology file '%s'", fileName.c_str());
+
+    vector<vector<int>> links(numClients);
+    string line;
+    int lineNo = 0;
+    while (getline(in, line)) {
+        lineNo++;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+            continue;
+
+        // "Client <index>:"
+        size_t colon = line.find(':');
+        stringstream head(colon == string::npos ? string() : line.substr(first, colon - first));
+        string keyword;
+        int client = -1;
+        if (!(head >> keyword >> client) || keyword != "Client")
+            throw cRuntimeError("%s:%d: expected \"Client <index>: <servers>\"", fileName.c_str(), lineNo);
+        if (client < 0 || client >= numClients)
+            throw cRuntimeError("%s:%d: client index %d out of range [0, %d)", fileName.c_str(), lineNo, client, numClients);
+
+        // Comma-separated server indices or "a-b" ranges.
+        stringstream list(line.substr(colon + 1));
+        string token;
+        while (getline(list, token, ',')) {
+            int from, to;
+            char dash;
+            stringstream entry(token);
+            if (!(entry >> from))
+                continue;   // Empty entry, e.g. a trailing comma.
+            to = from;
+            if (entry >> dash) {
+                if (dash != '-' || !(entry >> to))
+                    throw cRuntimeError("%s:%d: bad server entry '%s'", fileName.c_str(), lineNo, token.c_str());
+            }
+            if (from < 0 || to >= numServers || from > to)
+                throw cRuntimeError("%s:%d: server entry '%s' out of range [0, %d)", fileName.c_str(), lineNo, token.c_str(), numServers);
+            for (int s = from; s <= to; s++)
+                links[client].push_back(s);
+        }
+    }
+
+    for (int c = 0; c < numClients; c++) {
+        vector<int> &servers = links[c];
+        if (servers.empty())
+            throw cRuntimeError("%s: client %d has no servers", fileName.c_str(), c);
+        sort(servers.begin(), servers.end());
+        servers.erase(unique(servers.begin(), servers.end()), servers.end());
+    }
+    return links;
+}
+
+/*
+ * Function: initialize
+ * --------------------
+ *   Reads the topology, sizes the in[]/out[] gate vectors of every client and server to
+ *   their final degree, then connects each listed (client, server) pair in both directions
+ *   with the configured request and response delays.
+ */
+void TopologyBuilder::initialize() {
+    // Links between partitions must exist when the network is built, so they cannot be
+    // created here under parallel simulation (use the static NED wiring instead).
+    if (getEnvir()->getParsimNumPartitions() > 1)
+        throw cRuntimeError("topologyFile is not supported with parallel simulation");
+
+    cModule *network = getParentModule();
+    int numServers = network->par("numServers");
+    int numClients = network->par("numClients");
+    vector<vector<int>> links = readTopologyFile(par("topologyFile").stdstringValue(), numClients, numServers);
+    simtime_t requestDelay = par("requestDelay");
+    simtime_t responseDelay = par("responseDelay");
+
+    vector<cModule *> serverModules(numServers);
+    vector<int> serverDegree(numServers, 0);
+    for (int s = 0; s < numServers; s++)
+        serverModules[s] = network->getSubmodule("s", s);
+    for (auto &servers : links)
+        for (int s : servers)
+            serverDegree[s]++;
+    for (int s = 0; s < numServers; s++) {
+        serverModules[s]->setGateSize("in", serverDegree[s]);
+        serverModules[s]->setGateSize("out", serverDegree[s]);
+    }
+
+    long numLinks = 0;
+    vector<int> nextServerGate(numServers, 0);
+    for (int c = 0; c < numClients; c++) {
+        cModule *client = network->getSubmodule("c", c);
+        int degree = links[c].size();
+        client->setGateSize("in", degree);
+        client->setGateSize("out", degree);
+        for (int k = 0; k < degree; k++) {
+            int s = links[c][k];
+            int g = nextServerGate[s]++;
+            connect(client->gate("out", k), serverModules[s]->gate("in", g), requestDelay);
+            connect(serverModules[s]->gate("out", g), client->gate("in", k), responseDelay);
+        }
+        numLinks += degree;
+    }
+    EV << "TopologyBuilder: created " << numLinks << " client-server links for " << numClients
+       << " clients and " << numServers << " servers\n";
+}
+
+void TopologyBuilder::connect(cGate *from, cGate *to, simtime_t delay) {
+    cDelayChannel *channel = cDelayChannel::create("channel");
+    channel->setDelay(delay.dbl());
+    from->connectTo(to, channel);
+    channel->callInitialize();
+}
+
+void TopologyBuilder::handleMessage(cMessage *msg) {
+    throw cRuntimeError("TopologyBuilder does not process messages");
+}
@@ -0,0 +1,54 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _TOPOLOGYBUILDER_H
+#define _TOPOLOGYBUILDER_H
+
+#include <omnetpp.h>
+#include <string>
+#include <vector>
+using namespace omnetpp;
+using namespace std;
+
+/**
+ * @brief Wires clients to servers from a topology file at network setup.
+ *
+ * Instead of connecting every client to every server in NED, the builder
+ * reads the client-to-server links listed in 'topologyFile' (see topo.txt)
+ * and creates only those. Every gate vector is sized once to its final
+ * degree before any link is made, so setup is linear in the number of links.
+ *
+ * Link k of client c[i] uses c[i].out[k] / c[i].in[k]. At the server, the
+ * request and response directions of a link use the same index of in[] / out[],
+ * so servers can keep replying on the arrival gate index. Clients find the
+ * server behind each out[] gate by following the connection (see
+ * Client::buildServerLinks), so they do not assume out[i] leads to s[i].
+ *
+ * Wiring happens in initialization stage 0. Clients start sending in stage 1.
+ * Not available with parallel simulation, where every cross-partition link
+ * must be known when the network is built.
+ */
+class TopologyBuilder : public cSimpleModule {
+  public:
+    /**
+     * @brief Parses a topology file into the sorted, duplicate-free server list of each client.
+     *
+     * Lines have the form "Client <index>: <server>, <server>, ..." with 0-based
+     * client and server indices. A server entry may be a range "a-b". Blank lines
+     * and lines starting with '#' are ignored. Throws cRuntimeError on malformed
+     * lines, out-of-range indices and clients without any server.
+     */
+    static vector<vector<int>> readTopologyFile(const string &fileName, int numClients, int numServers);
+
+  protected:
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage *msg) override;
+
+  private:
+    // Creates a delay channel and connects 'from' to 'to' through it.
+    void connect(cGate *from, cGate *to, simtime_t delay);
+};
+
+#endif // _TOPOLOGYBUILDER_H
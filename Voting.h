@@ -0,0 +1,92 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+#ifndef _VOTING_H
+#define _VOTING_H
+
+#include <omnetpp.h>
+#include <vector>
+#include <algorithm>
+#include "ComputeKernels.h"
+#include "SmallVector.h"
+using namespace omnetpp;
+using namespace std;
+
+/**
+ * SubtaskVotes
+ * ------------
+ * Responses received for one subtask, stored as parallel flat arrays in arrival order.
+ * The arrays keep their capacity across rounds, so they are allocated only once.
+ */
+struct SubtaskVotes {
+    vector<int> assigned;                         // Server indices the subtask was sent to this round.
+    vector<int> servers;                          // 0-indexed server index of each response.
+    vector<KernelResult> results;                 // Result reported by servers[i].
+    vector<char> verified;                        // Witness mode: the witness of results[i] checked out.
+    vector<char> malicious;                       // Response i came from a malicious server.
+    vector<char> corrupted;                       // Response i was wrong, as its server reports (for the detection statistics).
+    vector<simtime_t> sentAt;                     // When the request to assigned[i] was sent.
+    int needed = 0;                               // Responses the decision waits for (extra replicas only stand in for slow ones).
+    int abandoned = 0;                            // Replicas given up on after a timeout.
+    int attempt = 0;                              // Timeouts so far; each one multiplies the timeout by retryBackoff.
+    bool hedged = false;                          // A hedged request was sent for the subtask.
+
+    size_t size() const { return servers.size(); }
+    void clear() {
+        assigned.clear(); servers.clear(); results.clear(); verified.clear(); malicious.clear(); corrupted.clear(); sentAt.clear();
+        needed = 0; abandoned = 0; attempt = 0; hedged = false;
+    }
+};
+
+/**
+ * @brief Majority vote over the responses of one subtask.
+ *
+ * Tallies the responses in a small inline vector (there are almost always only
+ * one or two distinct values, so no allocation and no tree map is needed) and
+ * picks the most frequent value. Ties are broken in favour of the larger value.
+ * Shared by clients and aggregators.
+ *
+ * @param votes     The responses received so far.
+ * @param remaining Number of responses still outstanding. The winner is only reported if
+ *                  those responses cannot overturn it, i.e. its count exceeds the runner-up's
+ *                  count by more than 'remaining'.
+ * @return The position in 'votes' of a response carrying the majority value, or -1 if the
+ *         outstanding responses could still change the outcome.
+ */
+inline int majorityVote(const SubtaskVotes &votes, int remaining = 0) {
+    struct VoteCount {
+        int first;        // Position of the first response with this value.
+        int count;        // Number of responses with this value.
+    };
+    SmallVector<VoteCount, 8> tally;
+    for (int i = 0; i < (int)votes.size(); i++) {
+       VoteCount *entry = tally.begin();
+       while (entry != tally.end() && votes.results[entry->first] != votes.results[i])
+          entry++;
+       if (entry != tally.end())
+          entry->count++;
+       else
+          tally.push_back({i, 1});
+    }
+    if (tally.empty())
+       return -1;
+    int best = 0;
+    for (int t = 1; t < (int)tally.size(); t++) {
+       if (tally[t].count > tally[best].count ||
+           (tally[t].count == tally[best].count && votes.results[tally[t].first] > votes.results[tally[best].first]))
+          best = t;
+    }
+    if (remaining > 0) {
+       int runnerUp = 0;
+       for (int t = 0; t < (int)tally.size(); t++)
+          if (t != best)
+             runnerUp = max(runnerUp, tally[t].count);
+       if (tally[best].count <= runnerUp + remaining)
+          return -1;
+    }
+    return tally[best].first;
+}
+
+#endif // _VOTING_H
@@ -0,0 +1,87 @@
+#!/bin/sh
+#
+# Roll Numbers: B22CS063, B22CS028
+#
+# Measures the wall-clock speedup of parallel simulation (PDES) against the number of
+# partitions on a single machine. For each partition count P the network is split into
+# P equal blocks of servers and clients (partition p gets s[] and c[] block p), every
+# partition runs as its own Cmdenv process, and the partitions talk through named pipes.
+# P = 1 is the sequential baseline. Every run simulates the same span, the sim-time-limit
+# of the Parallel1 config, since parallel runs never run out of events on their own.
+#
+# Usage: ./benchmark_parsim.sh [partitions...]      (default: 1 2 4)
+# Environment:
+#   CN        simulation executable (default ./cn)
+#   SERVERS   number of servers  (default 64)
+#   CLIENTS   number of clients  (default 64)
+#   ELEMENTS  input array length (default 8192)
+#   COMM      parsim communications class (default cNamedPipeCommunications)
+#
+# Prints a table and writes parsim_speedup.csv (partitions,servers,clients,seconds,speedup).
+
+CN=${CN:-./cn}
+SERVERS=${SERVERS:-64}
+CLIENTS=${CLIENTS:-64}
+ELEMENTS=${ELEMENTS:-8192}
+COMM=${COMM:-cNamedPipeCommunications}
+PARTITIONS=${*:-1 2 4}
+INI=parsim_bench.ini
+CSV=parsim_speedup.csv
+
+ARRAY=$(awk -v n="$ELEMENTS" 'BEGIN { for (i = 0; i < n; i++) printf "%s%d", (i ? "," : ""), (i * 7919) % 100003 }')
+
+# Writes the benchmark config for $1 partitions to $INI.
+write_ini() {
+    p=$1
+    {
+        echo "include omnetpp.ini"
+        echo "[Config Bench]"
+        echo "extends = Parallel1"
+        echo "Net.numServers = $SERVERS"
+        echo "Net.numClients = $CLIENTS"
+        echo "Net.gossipDegree = 4"
+        echo "**.c[*].arrayData = \"$ARRAY\""
+        echo "cmdenv-express-mode = true"
+        echo "cmdenv-status-frequency = 1000s"
+        if [ "$p" -gt 1 ]; then
+            echo "parallel-simulation = true"
+            echo "parsim-communications-class = \"$COMM\""
+            echo "parsim-synchronization-class = \"cNullMessageProtocol\""
+            echo "parsim-nullmessageprotocol-lookahead-class = \"cLinkDelayLookahead\""
+            echo "parsim-nullmessageprotocol-laziness = 0.5"
+            i=0
+            while [ $i -lt "$p" ]; do
+                echo "*.s[$((i * SERVERS / p))..$(((i + 1) * SERVERS / p - 1))].partition-id = $i"
+                echo "*.c[$((i * CLIENTS / p))..$(((i + 1) * CLIENTS / p - 1))].partition-id = $i"
+                i=$((i + 1))
+            done
+        fi
+    } > "$INI"
+}
+
+now() { date +%s.%N; }
+
+echo "partitions,servers,clients,seconds,speedup" > "$CSV"
+printf "%-11s %-10s %-8s\n" partitions seconds speedup
+base=""
+for p in $PARTITIONS; do
+    write_ini "$p"
+    start=$(now)
+    if [ "$p" -gt 1 ]; then
+        i=0
+        while [ $i -lt "$p" ]; do
+            "$CN" -u Cmdenv -n . -f "$INI" -c Bench -p$i,$p > "parsim_bench_p$i.log" 2>&1 &
+            i=$((i + 1))
+        done
+        wait
+    else
+        "$CN" -u Cmdenv -n . -f "$INI" -c Bench > parsim_bench_p0.log 2>&1
+    fi
+    end=$(now)
+    secs=$(echo "$end $start" | awk '{ printf "%.3f", $1 - $2 }')
+    [ -z "$base" ] && base=$secs
+    speedup=$(echo "$base $secs" | awk '{ printf "%.2f", $1 / $2 }')
+    printf "%-11s %-10s %-8s\n" "$p" "$secs" "$speedup"
+    echo "$p,$SERVERS,$CLIENTS,$secs,$speedup" >> "$CSV"
+done
+rm -f "$INI"
@@ -0,0 +1,80 @@
+#!/bin/sh
+#
+# Roll Numbers: B22CS063, B22CS028
+#
+# Runs the Scaling config of omnetpp.ini (a sweep over the number of servers and clients,
+# the array size and the fraction of malicious servers) under Cmdenv, one process per run,
+# and collects a machine-readable summary. Build in release mode first:
+#   make MODE=release NO_FILE_LOG=1
+#
+# Usage: ./benchmark_scaling.sh [run filter]     e.g. './benchmark_scaling.sh "\$servers==8"'
+# Environment:
+#   CN      simulation executable (default ./cn)
+#   CONFIG  config to run (default Scaling)
+#
+# The input arrays bench/array_<elements>.bin are created with perl on first use; their
+# content is pseudo-random but the same on every machine. Writes scaling_summary.csv:
+#   run,servers,clients,elements,malicious,seconds,events,events_per_sec,peak_rss_kb,
+#   job_latency_p50,job_latency_p99,round_makespan_p99,replica_rtt_p99,throughput
+# Latencies and throughput are means over the clients of their per-client scalars; the
+# latency percentiles are the ones the "percentiles" result recorder writes. Peak RSS
+# needs GNU time (/usr/bin/time -v) and is NA without it.
+
+CN=${CN:-./cn}
+CONFIG=${CONFIG:-Scaling}
+FILTER=$1
+CSV=scaling_summary.csv
+
+RUNS=$("$CN" -u Cmdenv -n . -c "$CONFIG" ${FILTER:+-r "$FILTER"} -q runs 2>/dev/null | grep '^Run [0-9]*:')
+if [ -z "$RUNS" ]; then
+    echo "No runs of config $CONFIG match the filter" >&2
+    exit 1
+fi
+
+# Input arrays: raw little-endian int32 (see MappedArray.h).
+mkdir -p bench
+for n in $(echo "$RUNS" | grep -o '\$elements=[0-9]*' | cut -d= -f2 | sort -un); do
+    [ -f "bench/array_$n.bin" ] ||
+        perl -e 'srand(42); print pack("l<*", map { int(rand(1000000)) } 1 .. $ARGV[0])' "$n" > "bench/array_$n.bin"
+done
+
+TIME=""
+/usr/bin/time -v true > /dev/null 2>&1 && TIME="/usr/bin/time -v -o scaling_time.txt"
+
+now() { date +%s.%N; }
+
+# Value of an iteration variable recorded in a .sca file ("itervar" in OMNeT++ 6, "attr" before).
+itervar() { awk -v name="$2" '($1 == "itervar" || $1 == "attr") && $2 == name { print $3; exit }' "$1"; }
+
+# Mean over the clients of a scalar, or NA if no client recorded it.
+client_mean() {
+    awk -v name="$2" '$1 == "scalar" && $2 ~ /\.c\[[0-9]+\]$/ && $3 == name { sum += $4; n++ }
+                      END { if (n) printf "%.6g", sum / n; else printf "NA" }' "$1"
+}
+
+echo "run,servers,clients,elements,malicious,seconds,events,events_per_sec,peak_rss_kb,job_latency_p50,job_latency_p99,round_makespan_p99,replica_rtt_p99,throughput" > "$CSV"
+printf "%-5s %-8s %-8s %-9s %-10s %-9s %-12s %-10s\n" run servers clients elements malicious seconds events/sec rss_kb
+for run in $(echo "$RUNS" | sed 's/^Run \([0-9]*\):.*/\1/'); do
+    log="scaling_run_$run.log"
+    start=$(now)
+    $TIME "$CN" -u Cmdenv -n . -c "$CONFIG" -r "$run" > "$log" 2>&1
+    end=$(now)
+    secs=$(echo "$end $start" | awk '{ printf "%.3f", $1 - $2 }')
+    events=$(grep -o 'event #[0-9]*' "$log" | tail -1 | tr -dc '0-9')
+    events=${events:-0}
+    rate=$(echo "$events $secs" | awk '{ printf "%.0f", $2 > 0 ? $1 / $2 : 0 }')
+    rss=NA
+    [ -n "$TIME" ] && rss=$(awk -F': ' '/Maximum resident set size/ { print $2 }' scaling_time.txt)
+    sca="results/$CONFIG-$run.sca"
+    if [ ! -f "$sca" ]; then
+        echo "Run $run failed, see $log" >&2
+        continue
+    fi
+    servers=$(itervar "$sca" servers)
+    clients=$(itervar "$sca" clients)
+    elements=$(itervar "$sca" elements)
+    malicious=$(itervar "$sca" malicious)
+    printf "%-5s %-8s %-8s %-9s %-10s %-9s %-12s %-10s\n" "$run" "$servers" "$clients" "$elements" "$malicious" "$secs" "$rate" "$rss"
+    echo "$run,$servers,$clients,$elements,$malicious,$secs,$events,$rate,$rss,$(client_mean "$sca" jobLatency:p50),$(client_mean "$sca" jobLatency:p99),$(client_mean "$sca" roundMakespan:p99),$(client_mean "$sca" replicaRtt:p99),$(client_mean "$sca" throughput)" >> "$CSV"
+done
+rm -f scaling_time.txt
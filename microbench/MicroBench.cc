@@ -0,0 +1,120 @@
+/*
+ * Roll Numbers: B22CS063, B22CS028
+ */
+
+
+/*
+ * Microbenchmarks of the client's hot paths, timed outside of a simulation:
+ *   parse     - parseArrayData on a comma-separated array (per element),
+ *   partition - cutting the array into subtask views with SubtaskChunker (per subtask),
+ *   vote      - majorityVote over the replica responses of one subtask (per subtask),
+ *   top       - ranking the servers by reputation and picking the replicas of one
+ *               subtask with the "top" ReplicaSelector (per round, the client's former
+ *               getTopServers()).
+ *
+ * Built with "make microbench" (see makefrag) against the simulation kernel library but
+ * without running a network. Usage:
+ *   microbench [servers] [elements] [repetitions]     (defaults: 64 100000 200)
+ * Prints one CSV line per benchmark: name,servers,elements,operations,ns_per_operation.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "SubtaskData.h"
+#include "Voting.h"
+#include "ReplicaSelector.h"
+using namespace std;
+
+// Keeps results observable so the compiler cannot drop the timed work.
+static volatile long sink;
+
+template <class Body>
+static void run(const char *name, int servers, size_t elements, long operations, Body body) {
+    auto start = chrono::steady_clock::now();
+    body();
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    printf("%s,%d,%zu,%ld,%.2f\n", name, servers, elements, operations, ns / operations);
+}
+
+int main(int argc, char **argv) {
+    int servers = argc > 1 ? atoi(argv[1]) : 64;
+    size_t elements = argc > 2 ? strtoul(argv[2], nullptr, 10) : 100000;
+    int repetitions = argc > 3 ? atoi(argv[3]) : 200;
+    if (servers < 1 || elements < (size_t)2 * servers || repetitions < 1) {
+        fprintf(stderr, "usage: %s [servers >= 1] [elements >= 2 * servers] [repetitions >= 1]\n", argv[0]);
+        return 1;
+    }
+    int replicas = servers / 2 + 1;
+
+    // The same deterministic input every run.
+    string text;
+    for (size_t i = 0; i < elements; i++) {
+        if (i > 0)
+            text += ',';
+        text += to_string((i * 7919) % 100003);
+    }
+
+    printf("benchmark,servers,elements,operations,ns_per_operation\n");
+
+    shared_ptr<vector<int>> array = make_shared<vector<int>>();
+    int parseRuns = max(1, repetitions / 20);
+    run("parse", servers, elements, (long)parseRuns * elements, [&]() {
+        for (int r = 0; r < parseRuns; r++) {
+            array->clear();
+            parseArrayData(text, *array);
+        }
+        sink = array->back();
+    });
+
+    vector<SubtaskData> chunks;
+    chunks.reserve(servers);
+    run("partition", servers, elements, (long)repetitions * servers, [&]() {
+        for (int r = 0; r < repetitions; r++) {
+            chunks.clear();
+            SubtaskChunker chunker(array, array->data(), array->size(), servers);
+            for (int i = 0; i < servers; i++)
+                chunks.push_back(chunker.chunk(i));
+        }
+        sink = chunks.back().size();
+    });
+
+    // One malicious response (off by one) among the replicas, like Server::corrupt().
+    SubtaskVotes votes;
+    for (int i = 0; i < replicas; i++) {
+        votes.servers.push_back(i);
+        votes.results.push_back(KernelResult{i == 0 ? 99 : 100});
+    }
+    run("vote", servers, elements, (long)repetitions * servers, [&]() {
+        long winners = 0;
+        for (long k = 0; k < (long)repetitions * servers; k++)
+            winners += majorityVote(votes);
+        sink = winners;
+    });
+
+    ServerLoad load;
+    for (int i = 0; i < servers; i++)
+        load.servers.push_back(i);
+    load.outstanding.assign(servers, 0);
+    load.queueLength.assign(servers, 0);
+    load.reputation.resize(servers);
+    for (int i = 0; i < servers; i++)
+        load.reputation[i] = (i * 37) % servers;
+    load.reputationKnown = true;
+    unique_ptr<ReplicaSelector> top(createReplicaSelector("top"));
+    vector<int> chosen;
+    run("top", servers, elements, repetitions, [&]() {
+        for (int r = 0; r < repetitions; r++) {
+            top->beginRound(load);
+            for (int i = 0; i < servers; i++) {
+                chosen.clear();
+                top->select(load, replicas, nullptr, chosen);   // Served from the ranking; no RNG needed.
+            }
+        }
+        sink = chosen.front();
+    });
+    return 0;
+}